@@ -0,0 +1,37 @@
+//! Bindings to the C interface of libara (service/include/ara.h).
+
+#[cfg(feature = "libara")]
+#[link(name = "ara")]
+extern "C" {
+    fn ara_planar_embedding(n: i32, edges: *const i32, m: i32, x: *mut i32, y: *mut i32) -> i32;
+}
+
+/// Finds straight-line planar embedding of the graph with vertices [1, n]
+/// through libara. The edges are handed over as one flat array and the
+/// library writes coordinates straight into the returned vectors.
+#[cfg(feature = "libara")]
+pub fn planar_embedding(n: u32, edges: &[(u32, u32)]) -> Option<Vec<(u32, u32)>> {
+    let flat: Vec<i32> = edges
+        .iter()
+        .flat_map(|&(u, v)| [u as i32, v as i32])
+        .collect();
+    let mut x = vec![0i32; n as usize];
+    let mut y = vec![0i32; n as usize];
+
+    // SAFETY: flat holds 2m endpoints, x and y hold n values each, and the
+    // library keeps no pointer to them after returning.
+    let status = unsafe {
+        ara_planar_embedding(
+            n as i32,
+            flat.as_ptr(),
+            edges.len() as i32,
+            x.as_mut_ptr(),
+            y.as_mut_ptr(),
+        )
+    };
+    if status != 0 {
+        return None;
+    }
+
+    Some(x.into_iter().zip(y).map(|(x, y)| (x as u32, y as u32)).collect())
+}
@@ -16,12 +16,73 @@ pub fn parse_output(output: &str) -> Vec<(u32, u32)> {
         .collect()
 }
 
+/// Decodes embedding written by `aracli --output-format=binary|varint`: a 12
+/// byte header ("ARAE", version, encoding, 2 reserved bytes, n as u32 LE)
+/// followed by the x array and the y array. Returns None if the output is not
+/// an embedding, as the empty output for a graph which is not planar.
+#[allow(dead_code)]
+pub fn parse_binary_output(output: &[u8]) -> Option<Vec<(u32, u32)>> {
+    if output.len() < 12 || &output[0..4] != b"ARAE" || output[4] != 1 {
+        return None;
+    }
+    let varint = output[5] == 1;
+    let n = u32::from_le_bytes(output[8..12].try_into().unwrap()) as usize;
+
+    let mut pos = 12;
+    let mut read_array = || -> Option<Vec<u32>> {
+        let mut values = Vec::with_capacity(n.min(output.len()));
+        let mut prev: i64 = 0;
+        for _ in 0..n {
+            if varint {
+                let mut x: u64 = 0;
+                let mut shift = 0;
+                loop {
+                    let byte = *output.get(pos)?;
+                    pos += 1;
+                    if shift >= 64 {
+                        return None;
+                    }
+                    x |= ((byte & 0x7f) as u64) << shift;
+                    shift += 7;
+                    if byte < 0x80 {
+                        break;
+                    }
+                }
+                // Undo zigzag encoding of the difference.
+                prev = prev.wrapping_add((x >> 1) as i64 ^ -((x & 1) as i64));
+                values.push(prev as u32);
+            } else {
+                values.push(u32::from_le_bytes(
+                    output.get(pos..pos + 4)?.try_into().unwrap(),
+                ));
+                pos += 4;
+            }
+        }
+        Some(values)
+    };
+
+    let xs = read_array()?;
+    let ys = read_array()?;
+    Some(xs.into_iter().zip(ys).collect())
+}
+
 #[allow(dead_code)]
 pub fn read_graph_edges(filename: &str) -> Vec<(u32, u32)> {
-    read_to_string(filename)
-        .expect("Failed to open input file.")
-        .lines()
-        .skip(1)
+    read_graph(filename).1
+}
+
+/// Reads number of vertices and edges of a graph in the input file format.
+#[allow(dead_code)]
+pub fn read_graph(filename: &str) -> (u32, Vec<(u32, u32)>) {
+    let content = read_to_string(filename).expect("Failed to open input file.");
+    let mut lines = content.lines();
+    let n = lines
+        .next()
+        .and_then(|header| header.split(" ").next())
+        .and_then(|n| n.parse::<u32>().ok())
+        .expect("Invalid input file header.");
+    let edges = lines
+        .filter(|line| line.len() > 0)
         .map(|line| {
             line.to_string()
                 .split(" ")
@@ -29,5 +90,6 @@ pub fn read_graph_edges(filename: &str) -> Vec<(u32, u32)> {
                 .next_tuple()
                 .unwrap()
         })
-        .collect()
+        .collect();
+    (n, edges)
 }
@@ -4,6 +4,7 @@ mod components;
 mod painter;
 
 mod constants;
+mod ffi;
 mod io;
 mod plane_graph;
 mod service;
@@ -1,12 +1,38 @@
+use std::io::{BufRead, BufReader, Read, Write};
+use std::os::unix::net::UnixStream;
 use std::process::Command;
+use std::sync::Mutex;
 
-use crate::io::{parse_output, read_graph_edges};
+#[cfg(feature = "libara")]
+use crate::{ffi, io::read_graph};
+#[cfg(not(feature = "libara"))]
+use crate::io::{parse_binary_output, read_graph_edges};
 use crate::plane_graph::PlaneGraph;
 
+/// Connection to `aracli --serve`, kept open between requests.
+#[cfg_attr(feature = "libara", allow(dead_code))]
+static CONNECTION: Mutex<Option<BufReader<UnixStream>>> = Mutex::new(None);
+
+/// Linked with libara, the file is read once and embedded in process.
+#[cfg(feature = "libara")]
+pub fn build_plane_graph_from_file(input_file_path: &str) -> Option<PlaneGraph> {
+    let (n, edges) = read_graph(input_file_path);
+    let embedding = ffi::planar_embedding(n, &edges)?;
+
+    Some(PlaneGraph {
+        n,
+        edges,
+        embedding,
+    })
+}
+
+#[cfg(not(feature = "libara"))]
 pub fn build_plane_graph_from_file(input_file_path: &str) -> Option<PlaneGraph> {
     let edges: Vec<(u32, u32)> = read_graph_edges(input_file_path);
     let output = call_ara_service(input_file_path);
-    let embedding = parse_output(&output);
+    // As with the text output, a graph which is not planar or was rejected
+    // has an empty embedding.
+    let embedding = parse_binary_output(&output).unwrap_or_default();
 
     let graph = PlaneGraph {
         n: embedding.len() as u32,
@@ -17,17 +43,95 @@ pub fn build_plane_graph_from_file(input_file_path: &str) -> Option<PlaneGraph>
     Some(graph)
 }
 
-fn call_ara_service(input_file_path: &str) -> String {
-    let output = String::from_utf8(
-        Command::new("aracli")
-            .arg(input_file_path)
-            .output()
-            .unwrap()
-            .stdout,
-    )
-    .expect("Failed to read output from ara service.");
+#[cfg_attr(feature = "libara", allow(dead_code))]
+fn call_ara_service(input_file_path: &str) -> Vec<u8> {
+    // If ARA_SOCKET points to a running `aracli --serve`, reuse a connection to
+    // it instead of starting a process for every graph.
+    if let Ok(socket_path) = std::env::var("ARA_SOCKET") {
+        match call_ara_server(&socket_path, input_file_path) {
+            ServerResponse::Embedding(output) if output.starts_with(b"ARAE") => return output,
+            // A server started without --output-format=binary answers in
+            // text, which must not pass for a rejected graph.
+            ServerResponse::Embedding(_) => {
+                log::warn!("ara server: output is not binary, running aracli")
+            }
+            // aracli would reject the graph in the same way, with no output.
+            ServerResponse::Error(message) => {
+                log::info!("ara server: {message}");
+                return Vec::new();
+            }
+            ServerResponse::Unreachable => {}
+        }
+    }
+
+    let output = Command::new("aracli")
+        .arg("--output-format=binary")
+        .arg(input_file_path)
+        .output()
+        .expect("Failed to read output from ara service.")
+        .stdout;
 
     // TODO: If failed do something
     // for example return result
     output
 }
+
+/// Response of `aracli --serve` to a graph.
+#[cfg_attr(feature = "libara", allow(dead_code))]
+enum ServerResponse {
+    /// The embedding in the output format of the server.
+    Embedding(Vec<u8>),
+    /// The server rejected the graph with the message.
+    Error(String),
+    /// The server could not be reached or broke the protocol.
+    Unreachable,
+}
+
+/// Sends the graph to the server and reads its record, "<index> ok <length>\n"
+/// followed by the embedding, or "<index> error <message>\n".
+#[cfg_attr(feature = "libara", allow(dead_code))]
+fn call_ara_server(socket_path: &str, input_file_path: &str) -> ServerResponse {
+    let Ok(input) = std::fs::read(input_file_path) else {
+        return ServerResponse::Unreachable;
+    };
+    let mut connection = CONNECTION.lock().unwrap();
+
+    for _ in 0..2 {
+        if connection.is_none() {
+            let Ok(stream) = UnixStream::connect(socket_path) else {
+                return ServerResponse::Unreachable;
+            };
+            *connection = Some(BufReader::new(stream));
+        }
+        let reader = connection.as_mut().unwrap();
+
+        let mut header = String::new();
+        let sent = reader.get_mut().write_all(&input).is_ok()
+            && reader.get_mut().write_all(b"\n").is_ok()
+            && reader.read_line(&mut header).map_or(false, |n| n > 0);
+        if !sent {
+            // The server may have been restarted, reconnect once.
+            *connection = None;
+            continue;
+        }
+
+        let fields: Vec<&str> = header.trim_end().splitn(3, ' ').collect();
+        match fields[..] {
+            [_, "error", message] => return ServerResponse::Error(message.to_string()),
+            [_, "ok", length] => {
+                if let Ok(length) = length.parse::<usize>() {
+                    let mut output = vec![0; length];
+                    if reader.read_exact(&mut output).is_ok() {
+                        return ServerResponse::Embedding(output);
+                    }
+                }
+            }
+            _ => {}
+        }
+        // The rest of the stream cannot be trusted.
+        *connection = None;
+        return ServerResponse::Unreachable;
+    }
+
+    ServerResponse::Unreachable
+}
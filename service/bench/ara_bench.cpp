@@ -0,0 +1,270 @@
+/**
+ * Benchmarks stages of the embedding pipeline separately on families of
+ * planar graphs of growing size, see generators.hpp. Inputs of every stage are
+ * prepared outside of the measured time. Writes JSON to stdout:
+ *
+ *     {"benchmarks": [{"family": ..., "n": ..., "m": ..., "stage": ...,
+ *      "repetitions": ..., "ms_min": ..., "ms_median": ..., "ms_mean": ...,
+ *      "ns_per_vertex": ...}, ...]}
+ *
+ * where ns_per_vertex is based on ms_min.
+ *
+ * Usage: ara_bench [--families=path,tree,...] [--stages=is_planar,...]
+ *                  [--min-n=100] [--max-n=1000000] [--repetitions=3]
+ *                  [--seed=1] [--threads=1]
+ * Sizes go from min-n to max-n by factors of 10. threads is passed to
+ * get_triangulation, find_faces, draw_triangulation and planar_embedding.
+ */
+#include "embedding.hpp"
+#include "generators.hpp"
+#include "graph.hpp"
+#include "half_edge.hpp"
+#include "incremental.hpp"
+#include "planar.hpp"
+#include "reduction.hpp"
+#include "triangulation.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+const char *STAGES[] = {"is_planar",         "is_planar_by_blocks",
+                        "is_planar_reduced", "test_planarity",
+                        "get_triangulation", "find_faces",
+                        "schnyder_wood",     "draw_triangulation",
+                        "connectivity",      "planar_embedding",
+                        "insert_edge"};
+
+struct Options {
+  std::vector<std::string> families, stages;
+  long long min_n = 100, max_n = 1000000;
+  int repetitions = 3;
+  unsigned long long seed = 1;
+  int threads = 1;
+};
+
+std::vector<std::string> split(const std::string &list) {
+  std::vector<std::string> items;
+  std::stringstream ss(list);
+  std::string item;
+  while (std::getline(ss, item, ','))
+    items.push_back(item);
+  return items;
+}
+
+// Keeps optimizer from dropping results.
+volatile long long sink;
+
+/**
+ * Measures stage on graph. prepare() builds the stage's input outside of the
+ * measured time and run() runs the stage on it.
+ */
+struct Measurement {
+  std::vector<double> ms;
+
+  template <typename Prepare, typename Run>
+  Measurement(int repetitions, Prepare prepare, Run run) {
+    for (int r = 0; r < repetitions; r++) {
+      auto input = prepare();
+      auto start = std::chrono::steady_clock::now();
+      sink = run(input);
+      std::chrono::duration<double, std::milli> elapsed =
+          std::chrono::steady_clock::now() - start;
+      ms.push_back(elapsed.count());
+    }
+    std::sort(ms.begin(), ms.end());
+  }
+};
+
+// Runs stage on graph, which has to be planar. Returns times in ms.
+std::vector<double> bench_stage(const std::string &stage, const Graph &graph,
+                                int repetitions, int threads) {
+  // Inputs shared by later stages.
+  Graph embedding = is_planar(graph);
+  Graph triangulation;
+  if (stage == "find_faces" || stage == "schnyder_wood" ||
+      stage == "draw_triangulation")
+    triangulation = get_triangulation(embedding);
+
+  if (stage == "is_planar")
+    return Measurement(
+               repetitions, [&]() { return &graph; },
+               [](const Graph *g) { return (long long)is_planar(*g).n; })
+        .ms;
+  if (stage == "is_planar_by_blocks")
+    return Measurement(
+               repetitions, [&]() { return &graph; },
+               [](const Graph *g) {
+                 return (long long)is_planar_by_blocks(*g).n;
+               })
+        .ms;
+  if (stage == "is_planar_reduced")
+    return Measurement(
+               repetitions, [&]() { return &graph; },
+               [](const Graph *g) {
+                 return (long long)is_planar_reduced(*g).n;
+               })
+        .ms;
+  if (stage == "test_planarity")
+    return Measurement(
+               repetitions, [&]() { return &graph; },
+               [](const Graph *g) { return (long long)test_planarity(*g); })
+        .ms;
+  if (stage == "get_triangulation")
+    return Measurement(
+               repetitions, [&]() { return &embedding; },
+               [&](const Graph *g) {
+                 return (long long)get_triangulation(*g, threads).half_edges();
+               })
+        .ms;
+  if (stage == "find_faces")
+    return Measurement(
+               repetitions, [&]() { return HalfEdgeGraph(triangulation); },
+               [&](const HalfEdgeGraph &g) {
+                 return (long long)find_faces(g, threads).size();
+               })
+        .ms;
+  if (stage == "schnyder_wood") {
+    HalfEdgeGraph rotation(triangulation);
+    int h = rotation.first[1];
+    int a = 1, b = rotation.head[h], c = rotation.head[rotation.face_next(h)];
+    return Measurement(
+               repetitions, [&]() { return &rotation; },
+               [&](const HalfEdgeGraph *g) {
+                 return (long long)get_schnyder_wood(*g, a, b, c).size();
+               })
+        .ms;
+  }
+  if (stage == "draw_triangulation")
+    return Measurement(
+               repetitions, [&]() { return &triangulation; },
+               [&](const Graph *g) {
+                 return (long long)draw_triangulation(*g, threads).size();
+               })
+        .ms;
+  if (stage == "connectivity")
+    return Measurement(
+               repetitions,
+               [&]() { return enumerate_adjacency_list(embedding); },
+               [](Graph &g) {
+                 GraphConnectivity GC(std::move(g));
+                 return (long long)GC.getArticulationPoints().size();
+               })
+        .ms;
+  if (stage == "insert_edge") {
+    // Up to 1000 edges, spread over the graph, are inserted back into the
+    // drawn embedding of the rest.
+    std::vector<std::pair<int, int>> edges, kept, removed;
+    for (int v = 1; v <= graph.n; v++)
+      for (auto u : graph.neighbours(v))
+        if (v < u)
+          edges.push_back({v, u});
+    size_t step = std::max<size_t>(1, edges.size() / 1000);
+    for (size_t i = 0; i < edges.size(); i++)
+      (i % step == 0 && removed.size() < 1000 ? removed : kept)
+          .push_back(edges[i]);
+    return Measurement(
+               repetitions,
+               [&]() {
+                 IncrementalEmbedding incremental(build_graph(graph.n, kept));
+                 incremental.coordinates();
+                 return incremental;
+               },
+               [&](IncrementalEmbedding &incremental) {
+                 for (auto [u, v] : removed)
+                   incremental.insert_edge(u, v);
+                 return (long long)incremental.edges();
+               })
+        .ms;
+  }
+  // planar_embedding replaces its argument, so it gets a copy.
+  return Measurement(
+             repetitions, [&]() { return graph; },
+             [&](Graph &g) {
+               return (long long)planar_embedding(g, threads).size();
+             })
+      .ms;
+}
+
+int main(int argc, char *argv[]) {
+  Options options;
+  for (auto &family : graph_families())
+    options.families.push_back(family.name);
+  options.stages.assign(std::begin(STAGES), std::end(STAGES));
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    auto value = [&](const char *prefix) -> const char * {
+      size_t k = std::string(prefix).size();
+      return arg.compare(0, k, prefix) == 0 ? argv[i] + k : nullptr;
+    };
+    if (const char *v = value("--families="))
+      options.families = split(v);
+    else if (const char *v = value("--stages="))
+      options.stages = split(v);
+    else if (const char *v = value("--min-n="))
+      options.min_n = std::atoll(v);
+    else if (const char *v = value("--max-n="))
+      options.max_n = std::atoll(v);
+    else if (const char *v = value("--repetitions="))
+      options.repetitions = std::max(1, std::atoi(v));
+    else if (const char *v = value("--seed="))
+      options.seed = std::strtoull(v, nullptr, 10);
+    else if (const char *v = value("--threads="))
+      options.threads = std::atoi(v);
+    else {
+      std::fprintf(stderr,
+                   "Usage: ara_bench [--families=path,tree,...] "
+                   "[--stages=is_planar,...]\n"
+                   "                 [--min-n=100] [--max-n=1000000] "
+                   "[--repetitions=3] [--seed=1] [--threads=1]\n");
+      return 1;
+    }
+  }
+
+  for (auto &name : options.families)
+    if (!find_family(name)) {
+      std::fprintf(stderr, "Unknown family: %s\n", name.c_str());
+      return 1;
+    }
+  for (auto &stage : options.stages)
+    if (std::find(std::begin(STAGES), std::end(STAGES), stage) ==
+        std::end(STAGES)) {
+      std::fprintf(stderr, "Unknown stage: %s\n", stage.c_str());
+      return 1;
+    }
+
+  std::printf("{\"benchmarks\":[");
+  bool first = true;
+  for (auto &name : options.families) {
+    const Family *family = find_family(name);
+    for (long long n = options.min_n; n <= options.max_n; n *= 10) {
+      std::mt19937_64 rng(options.seed);
+      Graph graph = build_graph(n, family->generate(n, rng));
+
+      for (auto &stage : options.stages) {
+        std::vector<double> ms =
+            bench_stage(stage, graph, options.repetitions, options.threads);
+        double mean = 0;
+        for (double t : ms)
+          mean += t / ms.size();
+
+        std::printf("%s\n{\"family\":\"%s\",\"n\":%lld,\"m\":%d,"
+                    "\"stage\":\"%s\",\"repetitions\":%d,\"ms_min\":%.3f,"
+                    "\"ms_median\":%.3f,\"ms_mean\":%.3f,"
+                    "\"ns_per_vertex\":%.2f}",
+                    first ? "" : ",", family->name, n, graph.edges(),
+                    stage.c_str(), options.repetitions, ms[0],
+                    ms[ms.size() / 2], mean, ms[0] * 1e6 / n);
+        std::fflush(stdout);
+        first = false;
+      }
+    }
+  }
+  std::printf("\n]}\n");
+}
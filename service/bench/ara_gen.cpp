@@ -0,0 +1,271 @@
+/**
+ * Streams a random planar graph in the input file format to a file or stdout.
+ * Edges are written as they are generated, so the memory used is O(|V|) at
+ * most, and graphs with 10^8 edges and more fit on any machine with the disk
+ * for them. The generator runs twice with the same seed, first only to count
+ * the edges for the header.
+ *
+ * Families:
+ *   triangulation  random stacked triangulation, 3n - 6 edges
+ *   delaunay       Delaunay triangulation of a jittered sqrt(n) x sqrt(n)
+ *                  lattice (n is rounded down to a rectangle)
+ *   sparse         spanning comb of the delaunay graph plus each other edge
+ *                  with probability --density
+ *   forest         --components random trees (default n / 1000)
+ *   deep           path with chords {i, i + 2}, DFS depth n from any vertex
+ *
+ * Usage: ara_gen <family> <n> [--seed=1] [--density=0.3] [--components=k]
+ *                [--no-relabel] [--output=path]
+ */
+#include "io.hpp"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+struct Options {
+  std::string family;
+  long long n = 0;
+  unsigned long long seed = 1;
+  double density = 0.3;
+  long long components = 0;
+  bool relabel = true;
+  const char *output = nullptr;
+};
+
+// Counts edges without writing them.
+struct CountingSink {
+  long long m = 0;
+  void edge(int, int) { m++; }
+};
+
+// Writes edges through a fixed buffer, renaming vertices by label.
+class FileSink {
+  int fd;
+  const std::vector<int> &label;
+  std::string buffer;
+  size_t len = 0;
+
+  void put(int x, char end) {
+    auto [p, ec] = std::to_chars(buffer.data() + len,
+                                 buffer.data() + buffer.size(), x);
+    *p = end;
+    len = p + 1 - buffer.data();
+  }
+
+public:
+  FileSink(int _fd, const std::vector<int> &_label)
+      : fd(_fd), label(_label), buffer(1 << 20, '\0') {}
+
+  ~FileSink() { flush(); }
+
+  void header(long long n, long long m) {
+    std::string line = std::to_string(n) + " " + std::to_string(m) + "\n";
+    write_all(fd, line);
+  }
+
+  void edge(int u, int v) {
+    if (len + 24 > buffer.size())
+      flush();
+    put(label[u], ' ');
+    put(label[v], '\n');
+  }
+
+  void flush() {
+    write_all(fd, buffer.substr(0, len));
+    len = 0;
+  }
+};
+
+// Number of vertices of a generated graph, n rounded for lattices.
+long long vertices(const Options &o) {
+  if (o.family == "delaunay" || o.family == "sparse") {
+    long long c = std::max(2ll, (long long)std::sqrt((double)o.n));
+    return std::max(2ll, o.n / c) * c;
+  }
+  return o.n;
+}
+
+template <typename Sink>
+void triangulation(const Options &o, std::mt19937_64 &rng, Sink &sink) {
+  int n = o.n;
+  if (n < 3) {
+    if (n == 2)
+      sink.edge(1, 2);
+    return;
+  }
+  sink.edge(1, 2);
+  sink.edge(2, 3);
+  sink.edge(1, 3);
+  std::vector<std::array<int, 3>> faces = {{1, 2, 3}, {1, 3, 2}};
+  faces.reserve(2 * n);
+  for (int v = 4; v <= n; v++) {
+    size_t f = rng() % faces.size();
+    auto [a, b, c] = faces[f];
+    sink.edge(a, v);
+    sink.edge(b, v);
+    sink.edge(c, v);
+    faces[f] = {a, b, v};
+    faces.push_back({b, c, v});
+    faces.push_back({c, a, v});
+  }
+}
+
+// True iff d lies inside the circle through a, b, c (counter-clockwise).
+bool in_circle(std::array<double, 2> a, std::array<double, 2> b,
+               std::array<double, 2> c, std::array<double, 2> d) {
+  double ax = a[0] - d[0], ay = a[1] - d[1];
+  double bx = b[0] - d[0], by = b[1] - d[1];
+  double cx = c[0] - d[0], cy = c[1] - d[1];
+  return (ax * ax + ay * ay) * (bx * cy - cx * by) -
+             (bx * bx + by * by) * (ax * cy - cx * ay) +
+             (cx * cx + cy * cy) * (ax * by - bx * ay) >
+         0;
+}
+
+// Lattice triangulation row by row. keep decides about edges which are not
+// in the spanning comb (rows and the first column).
+template <typename Sink, typename Keep>
+void lattice(const Options &o, std::mt19937_64 &rng, Sink &sink, Keep keep) {
+  long long c = std::max(2ll, (long long)std::sqrt((double)o.n));
+  long long r = vertices(o) / c;
+  std::uniform_real_distribution<double> jitter(-0.25, 0.25);
+
+  std::vector<std::array<double, 2>> prev(c), row(c);
+  for (long long i = 0; i < r; i++) {
+    for (long long j = 0; j < c; j++)
+      row[j] = {j + jitter(rng), i + jitter(rng)};
+    for (long long j = 0; j + 1 < c; j++) {
+      int v = i * c + j + 1;
+      sink.edge(v, v + 1);
+      if (i == 0)
+        continue;
+      // Quad a = (i - 1, j), b = (i - 1, j + 1), d = (i, j + 1), e = (i, j)
+      // in counter-clockwise order, split by its Delaunay diagonal.
+      int a = v - c, b = v - c + 1, d = v + 1, e = v;
+      bool flip = in_circle(prev[j], prev[j + 1], row[j + 1], row[j]);
+      if (j == 0)
+        sink.edge(a, e);
+      else if (keep(rng))
+        sink.edge(a, e);
+      if (keep(rng)) {
+        if (flip)
+          sink.edge(b, e);
+        else
+          sink.edge(a, d);
+      }
+    }
+    if (i > 0 && keep(rng))
+      sink.edge(i * c, (i + 1) * c);
+    std::swap(prev, row);
+  }
+}
+
+template <typename Sink>
+void forest(const Options &o, std::mt19937_64 &rng, Sink &sink) {
+  long long k = o.components > 0 ? o.components : std::max(1ll, o.n / 1000);
+  k = std::min(k, std::max(1ll, o.n));
+  // Tree t spans vertices [first(t), first(t + 1)).
+  auto first = [&](long long t) { return 1 + t * o.n / k; };
+  for (long long t = 0; t < k; t++)
+    for (long long v = first(t) + 1; v < first(t + 1); v++)
+      sink.edge(first(t) + rng() % (v - first(t)), v);
+}
+
+template <typename Sink> void deep(const Options &o, Sink &sink) {
+  for (long long v = 2; v <= o.n; v++) {
+    sink.edge(v - 1, v);
+    if (v >= 3)
+      sink.edge(v - 2, v);
+  }
+}
+
+template <typename Sink> void generate(const Options &o, Sink &sink) {
+  std::mt19937_64 rng(o.seed);
+  std::bernoulli_distribution coin(o.density);
+  if (o.family == "triangulation")
+    triangulation(o, rng, sink);
+  else if (o.family == "delaunay")
+    lattice(o, rng, sink, [](std::mt19937_64 &) { return true; });
+  else if (o.family == "sparse")
+    lattice(o, rng, sink, [&](std::mt19937_64 &g) { return coin(g); });
+  else if (o.family == "forest")
+    forest(o, rng, sink);
+  else if (o.family == "deep")
+    deep(o, sink);
+  else
+    throw std::invalid_argument("Unknown family: " + o.family + ".");
+}
+
+int main(int argc, char *argv[]) {
+  Options o;
+  std::vector<std::string> positional;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    auto value = [&](const char *prefix) -> const char * {
+      size_t k = std::string(prefix).size();
+      return arg.compare(0, k, prefix) == 0 ? argv[i] + k : nullptr;
+    };
+    if (const char *v = value("--seed="))
+      o.seed = std::strtoull(v, nullptr, 10);
+    else if (const char *v = value("--density="))
+      o.density = std::atof(v);
+    else if (const char *v = value("--components="))
+      o.components = std::atoll(v);
+    else if (const char *v = value("--output="))
+      o.output = v;
+    else if (arg == "--no-relabel")
+      o.relabel = false;
+    else if (arg.rfind("--", 0) != 0)
+      positional.push_back(arg);
+    else
+      positional.clear(), positional.resize(3);
+  }
+  if (positional.size() != 2 || std::atoll(positional[1].c_str()) < 1 ||
+      std::atoll(positional[1].c_str()) > 2000000000) {
+    std::fprintf(stderr,
+                 "Usage: ara_gen triangulation|delaunay|sparse|forest|deep <n>"
+                 "\n               [--seed=1] [--density=0.3] "
+                 "[--components=k] [--no-relabel] [--output=path]\n");
+    return 1;
+  }
+  o.family = positional[0];
+  o.n = std::atoll(positional[1].c_str());
+
+  try {
+    CountingSink counter;
+    generate(o, counter);
+
+    long long n = vertices(o);
+    std::vector<int> label(n + 1);
+    for (int v = 0; v <= n; v++)
+      label[v] = v;
+    if (o.relabel) {
+      std::mt19937_64 rng(o.seed ^ 0x9e3779b97f4a7c15ull);
+      std::shuffle(label.begin() + 1, label.end(), rng);
+    }
+
+    int fd = STDOUT_FILENO;
+    if (o.output &&
+        (fd = open(o.output, O_WRONLY | O_CREAT | O_TRUNC, 0644)) == -1)
+      throw std::runtime_error("Failed to open output file.");
+    {
+      FileSink sink(fd, label);
+      sink.header(n, counter.m);
+      generate(o, sink);
+    }
+    if (fd != STDOUT_FILENO)
+      close(fd);
+  } catch (const std::exception &e) {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+}
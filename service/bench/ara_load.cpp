@@ -0,0 +1,192 @@
+/**
+ * End-to-end load harness: runs aracli on every input file a number of times,
+ * up to --concurrency processes at once, and reports per file JSON with the
+ * latency distribution of runs, throughput in edges per second of the runs
+ * which exited with status 0 and peak resident set size of aracli:
+ *
+ *     {"results": [{"file": ..., "n": ..., "m": ..., "runs": ...,
+ *      "failures": ..., "latency_ms": {"p50": ..., "p90": ..., "p99": ...,
+ *      "max": ...}, "edges_per_s": ..., "peak_rss_mb": ...}, ...]}
+ *
+ * Output of aracli is discarded.
+ *
+ * Usage: ara_load [--aracli=aracli] [--runs=5] [--concurrency=1]
+ *                 [--arg=<aracli argument>]... <input file>...
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <map>
+#include <spawn.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+extern char **environ;
+
+struct Options {
+  std::string aracli = "aracli";
+  int runs = 5;
+  int concurrency = 1;
+  std::vector<std::string> args;
+  std::vector<std::string> files;
+};
+
+struct Result {
+  std::vector<double> ms;
+  int successes = 0;
+  int failures = 0;
+  long peak_rss_kb = 0;
+  double wall_s = 0;
+};
+
+using Clock = std::chrono::steady_clock;
+
+// Starts aracli on file with output discarded. Returns its pid, -1 on error.
+pid_t spawn(const Options &o, const std::string &file) {
+  std::vector<std::string> args = {o.aracli};
+  args.insert(args.end(), o.args.begin(), o.args.end());
+  args.push_back(file);
+  std::vector<char *> argv;
+  for (auto &arg : args)
+    argv.push_back(arg.data());
+  argv.push_back(nullptr);
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null",
+                                   O_WRONLY, 0);
+  pid_t pid;
+  int error = posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(),
+                           environ);
+  posix_spawn_file_actions_destroy(&actions);
+  return error ? -1 : pid;
+}
+
+Result run_file(const Options &o, const std::string &file) {
+  Result result;
+  std::map<pid_t, Clock::time_point> running;
+  int started = 0;
+  auto begin = Clock::now();
+
+  while (started < o.runs || !running.empty()) {
+    while (started < o.runs && (int)running.size() < o.concurrency) {
+      auto start = Clock::now();
+      pid_t pid = spawn(o, file);
+      started++;
+      if (pid == -1)
+        result.failures++;
+      else
+        running[pid] = start;
+    }
+    if (running.empty())
+      break;
+
+    int status;
+    rusage usage;
+    pid_t pid = wait4(-1, &status, 0, &usage);
+    if (pid == -1)
+      break;
+    auto it = running.find(pid);
+    if (it == running.end())
+      continue;
+    std::chrono::duration<double, std::milli> ms = Clock::now() - it->second;
+    running.erase(it);
+
+    result.ms.push_back(ms.count());
+    result.peak_rss_kb = std::max(result.peak_rss_kb, usage.ru_maxrss);
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+      result.successes++;
+    else
+      result.failures++;
+  }
+
+  std::chrono::duration<double> wall = Clock::now() - begin;
+  result.wall_s = wall.count();
+  std::sort(result.ms.begin(), result.ms.end());
+  return result;
+}
+
+double percentile(const std::vector<double> &sorted, double p) {
+  if (sorted.empty())
+    return 0;
+  size_t k = (size_t)(p / 100 * (sorted.size() - 1) + 0.5);
+  return sorted[std::min(k, sorted.size() - 1)];
+}
+
+// Quotes s as a JSON string.
+std::string json_string(const std::string &s) {
+  std::string out = "\"";
+  for (unsigned char c : s) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+      out += (char)c;
+    } else if (c < 0x20) {
+      char escape[7];
+      std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+      out += escape;
+    } else {
+      out += (char)c;
+    }
+  }
+  return out + "\"";
+}
+
+int main(int argc, char *argv[]) {
+  Options o;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    auto value = [&](const char *prefix) -> const char * {
+      size_t k = std::string(prefix).size();
+      return arg.compare(0, k, prefix) == 0 ? argv[i] + k : nullptr;
+    };
+    if (const char *v = value("--aracli="))
+      o.aracli = v;
+    else if (const char *v = value("--runs="))
+      o.runs = std::max(1, std::atoi(v));
+    else if (const char *v = value("--concurrency="))
+      o.concurrency = std::max(1, std::atoi(v));
+    else if (const char *v = value("--arg="))
+      o.args.push_back(v);
+    else if (arg.rfind("--", 0) != 0)
+      o.files.push_back(arg);
+    else
+      o.files.clear(), argc = 0;
+  }
+  if (o.files.empty()) {
+    std::fprintf(stderr, "Usage: ara_load [--aracli=aracli] [--runs=5] "
+                         "[--concurrency=1]\n"
+                         "                [--arg=<aracli argument>]... "
+                         "<input file>...\n");
+    return 1;
+  }
+
+  std::printf("{\"results\":[");
+  for (size_t i = 0; i < o.files.size(); i++) {
+    const std::string &file = o.files[i];
+    long long n = -1, m = -1;
+    if (FILE *f = std::fopen(file.c_str(), "r")) {
+      if (std::fscanf(f, "%lld %lld", &n, &m) != 2)
+        n = m = -1;
+      std::fclose(f);
+    }
+
+    Result r = run_file(o, file);
+    std::printf("%s\n{\"file\":%s,\"n\":%lld,\"m\":%lld,\"runs\":%d,"
+                "\"failures\":%d,\"latency_ms\":{\"p50\":%.3f,\"p90\":%.3f,"
+                "\"p99\":%.3f,\"max\":%.3f},\"edges_per_s\":%.0f,"
+                "\"peak_rss_mb\":%.1f}",
+                i ? "," : "", json_string(file).c_str(), n, m, o.runs,
+                r.failures,
+                percentile(r.ms, 50), percentile(r.ms, 90),
+                percentile(r.ms, 99), percentile(r.ms, 100),
+                r.wall_s > 0 ? (double)m * r.successes / r.wall_s : 0.0,
+                r.peak_rss_kb / 1024.0);
+    std::fflush(stdout);
+  }
+  std::printf("\n]}\n");
+}
@@ -0,0 +1,140 @@
+#include "generators.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Renames vertices by a random permutation of [1, n] and shuffles the edges.
+EdgeList relabel(int n, EdgeList edges, std::mt19937_64 &rng) {
+  std::vector<int> label(n + 1);
+  for (int v = 0; v <= n; v++)
+    label[v] = v;
+  std::shuffle(label.begin() + 1, label.end(), rng);
+  for (auto &[u, v] : edges) {
+    u = label[u];
+    v = label[v];
+  }
+  std::shuffle(edges.begin(), edges.end(), rng);
+  return edges;
+}
+
+} // namespace
+
+EdgeList path_graph(int n, std::mt19937_64 &rng) {
+  EdgeList edges;
+  edges.reserve(n);
+  for (int v = 2; v <= n; v++)
+    edges.push_back({v - 1, v});
+  return relabel(n, std::move(edges), rng);
+}
+
+EdgeList random_tree(int n, std::mt19937_64 &rng) {
+  EdgeList edges;
+  edges.reserve(n);
+  for (int v = 2; v <= n; v++)
+    edges.push_back({(int)(rng() % (v - 1)) + 1, v});
+  return relabel(n, std::move(edges), rng);
+}
+
+EdgeList grid_graph(int n, std::mt19937_64 &rng) {
+  int k = std::max(1, (int)std::sqrt((double)n));
+  EdgeList edges;
+  edges.reserve(2 * n);
+  for (int v = 1; v <= n; v++) {
+    if ((v - 1) % k + 1 < k && v + 1 <= n)
+      edges.push_back({v, v + 1});
+    if (v + k <= n)
+      edges.push_back({v, v + k});
+  }
+  return relabel(n, std::move(edges), rng);
+}
+
+EdgeList random_maximal_planar(int n, std::mt19937_64 &rng) {
+  EdgeList edges;
+  if (n < 3) {
+    if (n == 2)
+      edges.push_back({1, 2});
+    return edges;
+  }
+
+  edges.reserve(3 * n - 6);
+  edges.push_back({1, 2});
+  edges.push_back({2, 3});
+  edges.push_back({1, 3});
+
+  // Both faces of the triangle, every insertion replaces a face by three.
+  std::vector<std::array<int, 3>> faces = {{1, 2, 3}, {1, 3, 2}};
+  faces.reserve(2 * n);
+  for (int v = 4; v <= n; v++) {
+    size_t f = rng() % faces.size();
+    auto [a, b, c] = faces[f];
+    edges.push_back({a, v});
+    edges.push_back({b, v});
+    edges.push_back({c, v});
+    faces[f] = {a, b, v};
+    faces.push_back({b, c, v});
+    faces.push_back({c, a, v});
+  }
+  return relabel(n, std::move(edges), rng);
+}
+
+EdgeList nested_triangles(int n, std::mt19937_64 &rng) {
+  EdgeList edges;
+  if (n < 3)
+    return path_graph(n, rng);
+
+  int k = n / 3;
+  edges.reserve(3 * n);
+  for (int t = 0; t < k; t++) {
+    int a = 3 * t + 1;
+    edges.push_back({a, a + 1});
+    edges.push_back({a + 1, a + 2});
+    edges.push_back({a, a + 2});
+    if (t + 1 < k) {
+      // Triangulate the annulus between triangle t and triangle t + 1.
+      int b = a + 3;
+      for (int i = 0; i < 3; i++) {
+        edges.push_back({a + i, b + i});
+        edges.push_back({a + i, b + (i + 1) % 3});
+      }
+    }
+  }
+  // Leftover vertices go into the innermost triangle.
+  int a = 3 * (k - 1) + 1;
+  for (int v = 3 * k + 1; v <= n; v++) {
+    edges.push_back({a, v});
+    edges.push_back({a + 1, v});
+    edges.push_back({v - 1 > 3 * k ? v - 1 : a + 2, v});
+  }
+  return relabel(n, std::move(edges), rng);
+}
+
+EdgeList star_graph(int n, std::mt19937_64 &rng) {
+  EdgeList edges;
+  edges.reserve(n);
+  for (int v = 2; v <= n; v++)
+    edges.push_back({1, v});
+  return relabel(n, std::move(edges), rng);
+}
+
+const std::vector<Family> &graph_families() {
+  static const std::vector<Family> families = {
+      {"path", path_graph},
+      {"tree", random_tree},
+      {"grid", grid_graph},
+      {"maximal", random_maximal_planar},
+      {"nested", nested_triangles},
+      {"star", star_graph},
+  };
+  return families;
+}
+
+const Family *find_family(const std::string &name) {
+  for (auto &family : graph_families())
+    if (name == family.name)
+      return &family;
+  return nullptr;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Generators of planar graph families for benchmarks. Every generator returns
+ * edges of a simple graph on vertices [1, n]. Vertices are relabelled in
+ * random order, so that neighbours are not neighbouring in memory as they are
+ * in real inputs.
+ */
+
+using EdgeList = std::vector<std::pair<int, int>>;
+
+// Path 1 - 2 - ... - n.
+EdgeList path_graph(int n, std::mt19937_64 &rng);
+
+// Random recursive tree: vertex v is attached to a random earlier vertex.
+EdgeList random_tree(int n, std::mt19937_64 &rng);
+
+// Grid with floor(sqrt(n)) columns and n vertices.
+EdgeList grid_graph(int n, std::mt19937_64 &rng);
+
+// Random stacked triangulation: every vertex is put into a random face of the
+// previous triangulation. Maximal planar, 3n - 6 edges.
+EdgeList random_maximal_planar(int n, std::mt19937_64 &rng);
+
+// n / 3 nested triangles, each joined to the next by a triangulated annulus.
+// Maximal planar with depth of order n.
+EdgeList nested_triangles(int n, std::mt19937_64 &rng);
+
+// Star with a centre of degree n - 1.
+EdgeList star_graph(int n, std::mt19937_64 &rng);
+
+struct Family {
+  const char *name;
+  EdgeList (*generate)(int n, std::mt19937_64 &rng);
+};
+
+// All families above.
+const std::vector<Family> &graph_families();
+
+// Family with given name, nullptr if there is none.
+const Family *find_family(const std::string &name);
@@ -0,0 +1,171 @@
+/**
+ * Compares the linked adjacency list layout, std::vector<std::list<int>>, with
+ * the CSR Graph on building and traversing grid graphs. Reports wall time,
+ * number of heap allocations and peak heap usage of both.
+ *
+ * Usage: ara_graph_bench [side of the grid] [number of traversals]
+ */
+#include "graph.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <new>
+#include <vector>
+
+static size_t allocations = 0;
+static size_t live_bytes = 0;
+static size_t peak_bytes = 0;
+
+void *operator new(size_t size) {
+  allocations++;
+  live_bytes += size;
+  peak_bytes = std::max(peak_bytes, live_bytes);
+  size_t *p = (size_t *)std::malloc(size + sizeof(size_t));
+  if (!p)
+    throw std::bad_alloc();
+  *p = size;
+  return p + 1;
+}
+
+void operator delete(void *ptr) noexcept {
+  if (!ptr)
+    return;
+  size_t *p = (size_t *)ptr - 1;
+  live_bytes -= *p;
+  std::free(p);
+}
+
+void operator delete(void *ptr, size_t) noexcept { operator delete(ptr); }
+
+struct Stats {
+  double build_ms, traverse_ms;
+  size_t allocations, peak_bytes;
+  long long checksum;
+};
+
+double ms_since(std::chrono::steady_clock::time_point start) {
+  auto d = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::milli>(d).count();
+}
+
+// Visits all vertices with BFS, the access pattern of most pipeline stages.
+template <class Neighbours>
+long long bfs(int n, Neighbours neighbours, std::vector<int> &queue,
+              std::vector<bool> &visited) {
+  long long checksum = 0;
+  visited.assign(n + 1, false);
+  for (int s = 1; s <= n; s++) {
+    if (visited[s])
+      continue;
+    visited[s] = true;
+    queue.clear();
+    queue.push_back(s);
+    for (size_t i = 0; i < queue.size(); i++) {
+      int v = queue[i];
+      for (auto u : neighbours(v)) {
+        checksum += u;
+        if (!visited[u]) {
+          visited[u] = true;
+          queue.push_back(u);
+        }
+      }
+    }
+  }
+  return checksum;
+}
+
+Stats bench_list(int n, const std::vector<std::pair<int, int>> &edges,
+                 int rounds) {
+  Stats s{};
+  size_t base_allocations = allocations;
+  peak_bytes = live_bytes;
+  size_t base_bytes = live_bytes;
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::list<int>> list(n + 1);
+  for (auto &[u, v] : edges) {
+    list[u].push_back(v);
+    list[v].push_back(u);
+  }
+  s.build_ms = ms_since(start);
+
+  std::vector<int> queue;
+  std::vector<bool> visited;
+  queue.reserve(n);
+  start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++)
+    s.checksum += bfs(
+        n, [&](int v) -> const std::list<int> & { return list[v]; }, queue,
+        visited);
+  s.traverse_ms = ms_since(start) / rounds;
+
+  s.allocations = allocations - base_allocations;
+  s.peak_bytes = peak_bytes - base_bytes;
+  return s;
+}
+
+Stats bench_csr(int n, const std::vector<std::pair<int, int>> &edges,
+                int rounds) {
+  Stats s{};
+  size_t base_allocations = allocations;
+  peak_bytes = live_bytes;
+  size_t base_bytes = live_bytes;
+
+  auto start = std::chrono::steady_clock::now();
+  Graph graph = build_graph(n, edges);
+  s.build_ms = ms_since(start);
+
+  std::vector<int> queue;
+  std::vector<bool> visited;
+  queue.reserve(n);
+  start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; r++)
+    s.checksum += bfs(
+        n, [&](int v) { return graph.neighbours(v); }, queue, visited);
+  s.traverse_ms = ms_since(start) / rounds;
+
+  s.allocations = allocations - base_allocations;
+  s.peak_bytes = peak_bytes - base_bytes;
+  return s;
+}
+
+int main(int argc, char *argv[]) {
+  int k = (argc > 1) ? std::atoi(argv[1]) : 1000;
+  int rounds = (argc > 2) ? std::atoi(argv[2]) : 5;
+
+  // k x k grid with vertices numbered in random order, so that neighbouring
+  // vertices are not neighbouring in memory (as in real inputs).
+  int n = k * k;
+  std::vector<int> label(n + 1);
+  for (int v = 1; v <= n; v++)
+    label[v] = v;
+  std::srand(1);
+  for (int v = n; v > 1; v--)
+    std::swap(label[v], label[1 + std::rand() % v]);
+
+  std::vector<std::pair<int, int>> edges;
+  edges.reserve(2 * n);
+  for (int i = 0; i < k; i++)
+    for (int j = 0; j < k; j++) {
+      int v = i * k + j + 1;
+      if (j + 1 < k)
+        edges.push_back({label[v], label[v + 1]});
+      if (i + 1 < k)
+        edges.push_back({label[v], label[v + k]});
+    }
+
+  // CSR goes first, so it does not run on a heap fragmented by list nodes.
+  Stats csr = bench_csr(n, edges, rounds);
+  Stats list = bench_list(n, edges, rounds);
+
+  if (list.checksum != csr.checksum)
+    std::fprintf(stderr, "Traversal mismatch.\n");
+
+  std::printf("|V| = %d, |E| = %zu\n", n, edges.size());
+  std::printf("%-6s %12s %12s %14s %14s\n", "layout", "build [ms]",
+              "bfs [ms]", "allocations", "peak [MB]");
+  for (auto &[name, s] : {std::pair{"list", list}, std::pair{"csr", csr}})
+    std::printf("%-6s %12.1f %12.1f %14zu %14.1f\n", name, s.build_ms,
+                s.traverse_ms, s.allocations, s.peak_bytes / 1048576.0);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+/*
+ * C interface of libara. Graphs are passed as flat edge arrays owned by the
+ * caller: edge i is {edges[2 * i], edges[2 * i + 1]}, vertices are numbered
+ * [1, n]. A repeated edge is merged into its first occurrence. Results are
+ * written into buffers provided by the caller, the library keeps no pointer
+ * to either after returning. All functions are thread-safe.
+ */
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#define ARA_API __declspec(dllexport)
+#else
+#define ARA_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum ara_status {
+  ARA_OK = 0,
+  ARA_NOT_PLANAR = 1,       /* the graph is not planar */
+  ARA_INVALID_ARGUMENT = 2, /* bad sizes, endpoints or loops, see functions */
+  ARA_INTERNAL_ERROR = 3,   /* e.g. out of memory */
+} ara_status;
+
+/* Returns static description of the status. */
+ARA_API const char *ara_status_message(ara_status status);
+
+/**
+ * Checks whether the graph is planar and finds its combinatoric embedding if
+ * it is.
+ *
+ * @complexity O(|V| + |E|)
+ * @param n Number of vertices.
+ * @param edges 2m endpoints, each from [1, n], no loops.
+ * @param m Number of edges.
+ * @param offsets NULL, or buffer for n + 1 offsets: neighbours of v in
+ * rotation order are rotation[offsets[v - 1]..offsets[v]).
+ * @param rotation NULL, or buffer for 2m neighbours, of which offsets[n]
+ * are written. If both buffers are NULL, only planarity is tested and no
+ * embedding is built.
+ * @return ARA_OK if planar, ARA_NOT_PLANAR or ARA_INVALID_ARGUMENT.
+ */
+ARA_API ara_status ara_is_planar(int32_t n, const int32_t *edges, int32_t m,
+                                 int32_t *offsets, int32_t *rotation);
+
+/**
+ * Triangulates the planar graph. For n >= 3 the triangulation has exactly
+ * 3n - 6 edges, which contain the edges of the graph.
+ *
+ * @complexity O(|V| + |E|)
+ * @param n Number of vertices, at least 3.
+ * @param edges 2m endpoints, each from [1, n], no loops.
+ * @param m Number of edges.
+ * @param triangulation Buffer for 2(3n - 6) endpoints of the edges of the
+ * triangulation.
+ * @return ARA_OK, ARA_NOT_PLANAR or ARA_INVALID_ARGUMENT.
+ */
+ARA_API ara_status ara_get_triangulation(int32_t n, const int32_t *edges,
+                                         int32_t m, int32_t *triangulation);
+
+/**
+ * Finds straight-line planar embedding of the graph on
+ * {0..n-2} x {0..n-2} grid.
+ *
+ * @complexity O(|V| + |E|)
+ * @param n Number of vertices, at least 3.
+ * @param edges 2m endpoints, each from [1, n], no loops.
+ * @param m Number of edges.
+ * @param x Buffer for n coordinates, vertex v gets x[v - 1].
+ * @param y Buffer for n coordinates, vertex v gets y[v - 1].
+ * @return ARA_OK, ARA_NOT_PLANAR or ARA_INVALID_ARGUMENT.
+ */
+ARA_API ara_status ara_planar_embedding(int32_t n, const int32_t *edges,
+                                        int32_t m, int32_t *x, int32_t *y);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+/*
+ * Per-call arenas for temporaries of the embedding pipeline. Linked lists,
+ * queues and face lists of a stage are allocated from a monotonic buffer and
+ * released at once when the stage ends, so a call makes a handful of large
+ * allocations instead of one per list node.
+ *
+ * The arena of a Scope is used only by the thread which created it. Threads
+ * with no Scope alive allocate from the default resource.
+ */
+
+namespace arena {
+
+/**
+ * Memory resource for temporaries: the arena of the innermost Scope alive on
+ * this thread, or the default resource if there is none.
+ */
+std::pmr::memory_resource *resource();
+
+/**
+ * Makes resource() return a fresh monotonic arena while alive. Everything
+ * allocated from it is released when the Scope is destroyed, so no container
+ * using it may outlive the Scope. Scopes nest.
+ */
+class Scope {
+  std::pmr::monotonic_buffer_resource buffer;
+  std::pmr::memory_resource *previous;
+
+public:
+  /**
+   * @param initial_size Size of the first block of the arena in bytes. Later
+   * blocks grow geometrically.
+   */
+  explicit Scope(size_t initial_size = 1 << 16);
+  ~Scope();
+
+  Scope(const Scope &) = delete;
+  Scope &operator=(const Scope &) = delete;
+};
+
+} // namespace arena
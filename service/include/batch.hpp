@@ -0,0 +1,110 @@
+#pragma once
+
+#include "graph.hpp"
+#include "io.hpp"
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+
+struct BatchOptions {
+  int threads = 0;      // worker threads, 0 means default_threads()
+  bool ordered = true;  // emit results in input order or as they complete
+  OutputFormat format = OutputFormat::Text;
+  size_t max_in_flight = 0; // graphs parsed but not written, 0 means
+                            // 64 * threads
+};
+
+/**
+ * Encodes result record for graph with given index. Successful records are
+ *
+ *     <index> ok <length>\n<length bytes of embedding in given format>
+ *
+ * and failed ones are
+ *
+ *     <index> error <message>\n
+ */
+std::string encode_record(long long index,
+                          const std::vector<std::pair<int, int>> &embedding,
+                          OutputFormat format);
+std::string encode_error_record(long long index, const std::string &message);
+
+/**
+ * Collects records and writes them to a file descriptor, either as they come
+ * or in order of indices starting from 0. Bounds the number of records
+ * between acquire() and being written. After a failed write, records are
+ * dropped.
+ *
+ * Records are written by the thread which puts them, or, in background mode,
+ * by a thread running write_loop(), so that a slow reader of the output does
+ * not hold up the threads producing records.
+ */
+class RecordSink {
+  int fd;
+  bool ordered;
+  bool background;
+  size_t max_in_flight;
+
+  std::mutex m;
+  std::condition_variable cv;
+  bool failed;
+  bool closed;
+  size_t in_flight;   // acquired and not written
+  size_t ready_count; // records in ready
+  long long next_index;
+  std::string ready; // records to be written next
+  std::map<long long, std::string> pending;
+
+  void write(const std::string &out);
+
+public:
+  RecordSink(int fd, bool ordered, size_t max_in_flight,
+             bool background = false);
+
+  // Blocks until another record may be started.
+  void acquire();
+
+  // Hands over the record of given index, empty records are only counted.
+  void put(long long index, std::string record);
+
+  // False after a failed write.
+  bool ok();
+
+  // Blocks until every acquired record has been written.
+  void drain();
+
+  // Writes records in background mode until close().
+  void write_loop();
+
+  // Makes write_loop() return once everything put is written.
+  void close();
+};
+
+/**
+ * Embeds graph and encodes its record, an error record if the graph is
+ * invalid. Every thread keeps the buffers of the planarity test between
+ * calls, see PlanarityWorkspace.
+ *
+ * @param index Index of the graph.
+ * @param graph The graph.
+ * @param format Format of the embedding.
+ * @param record Receives the record.
+ * @return False iff an error record was produced.
+ */
+bool embed_record(long long index, Graph &graph, OutputFormat format,
+                  std::string &record);
+
+/**
+ * Embeds every graph of a stream of concatenated graphs (in the input file
+ * format) read from in_fd and writes one record per graph to out_fd.
+ * The reading thread parses while a work-stealing pool computes embeddings.
+ * An invalid graph only produces an error record, but a broken stream (see
+ * GraphStreamReader) ends the batch after an error record for it. So does a
+ * failed write.
+ *
+ * @param in_fd Input file descriptor.
+ * @param out_fd Output file descriptor.
+ * @param options Batch options.
+ * @return Number of error records.
+ */
+long long run_batch(int in_fd, int out_fd, const BatchOptions &options);
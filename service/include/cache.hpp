@@ -0,0 +1,81 @@
+#pragma once
+
+#include "graph.hpp"
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Content address of a graph: 128-bit hash of |V| and of the set of its edges
+ * with endpoints normalized to {min, max}. It depends neither on the order of
+ * edges nor on the order of their endpoints.
+ */
+struct GraphKey {
+  uint64_t hi, lo;
+
+  // 32 lowercase hex digits.
+  std::string hex() const;
+};
+
+/**
+ * Computes content address of the graph. Edges are hashed one by one and the
+ * hashes are summed, so the key does not depend on the order of edges or of
+ * their endpoints, without sorting. It is not collision-resistant.
+ *
+ * @complexity O(|V| + |E|)
+ * @param graph The graph.
+ * @return Key of the graph.
+ */
+GraphKey graph_key(const Graph &graph);
+
+/**
+ * On-disk cache of embedding results, one file per graph named by its key.
+ * A file holds the rotation system, the triangulation and the coordinates
+ * (first, so that reading them touches as few pages as possible), or only a
+ * header and the adjacency for a graph which is not planar. Files are read
+ * through mmap, and a file is a hit only if the edges of its rotation system
+ * or adjacency are those of the graph, as keys can collide.
+ *
+ * Several processes may share a directory: files are written under temporary
+ * names and renamed into place, readers validate size and header, and the
+ * least recently used files are removed when the directory grows over its
+ * limit. Failures to read or write entries are treated as misses.
+ */
+class ResultCache {
+  std::string directory;
+  long long max_bytes;
+
+  std::string path(const GraphKey &key) const;
+  bool lookup(const GraphKey &key, const Graph &graph,
+              std::vector<std::pair<int, int>> &coords) const;
+  void store(const GraphKey &key, const Graph &graph, const Graph &embedding,
+             const Graph &triangulation,
+             const std::vector<std::pair<int, int>> &coords) const;
+  void evict() const;
+
+public:
+  /**
+   * Creates the directory if needed. Throws std::runtime_error if it cannot
+   * be created.
+   *
+   * @param directory Cache directory.
+   * @param max_bytes Limit of the total size of entries.
+   */
+  ResultCache(std::string directory, long long max_bytes);
+
+  /**
+   * Same as planar_embedding, but answered from the cache if the graph, up to
+   * the order of edges, was embedded before. Repeated edges are merged
+   * first. Forests and disjoint cycles are drawn directly and not stored.
+   * Throws exception if the graph is not planar or has less than 3 vertices.
+   *
+   * @complexity O(|V| + |E|), without the planarity test on a hit
+   * @param graph The graph.
+   * @param threads Number of threads testing planarity, triangulating and
+   * drawing, see planar_embedding.
+   * @return Planar embedding as vector of coordinates on the grid.
+   */
+  std::vector<std::pair<int, int>> planar_embedding(const Graph &graph,
+                                                    int threads = 1) const;
+};
@@ -1,18 +1,61 @@
 #pragma once
 
-#include <list>
+#include "graph.hpp"
+#include "planar.hpp"
 #include <vector>
 
+/**
+ * Finds straight-line planar embedding of a triangulation on
+ * {0..|V|-2} x {0..|V|-2} grid, using its Schnyder wood. No two edges of the
+ * triangulation cross, so the drawing is valid for each of its subgraphs too.
+ *
+ * @complexity O(|V|)
+ * @param triangulated Triangulation with at least 3 vertices, adjacency
+ * sorted according to its combinatorial embedding.
+ * @param threads Number of threads computing the coordinates, 0 means
+ * default_threads(). The drawing does not depend on it.
+ * @return Planar embedding as vector of coordinates on the grid.
+ */
+std::vector<std::pair<int, int>> draw_triangulation(const Graph &triangulated,
+                                                    int threads = 1);
+
 /**
  * Finds straight-line planar embedding of a simple graph on
  * {0..|V|-2} x {0..|V|-2} grid. Assumes the graph does not
- * contain loops or multiedges. The graphs does not have to be connected.
+ * contain loops. Repeated edges are merged in graph first, see
+ * merge_parallel_edges. The graph does not have to be connected.
+ * Planarity is tested on the kernel of the graph, see is_planar_reduced.
+ * Forests and disjoint cycles are drawn directly, see draw_trees_and_cycles.
  *
- * Throws exception if the graphs is not planar.
+ * Throws exception if the graphs is not planar or has less than 3 vertices.
  *
  * @complexity O(|V| + |E|)
- * @param list Adjacency list of the graph.
+ * @param graph The graph.
+ * @param threads Number of threads testing planarity, triangulating and
+ * drawing. Other than 1 tests biconnected components separately, see
+ * is_planar_by_blocks, which may give another rotation system and drawing
+ * than 1. The drawing of a given rotation system does not depend on it.
+ * @param workspace Buffers of is_planar reused across calls, or nullptr.
+ * @return Planar embedding as vector of coordinates on the grid.
+ */
+std::vector<std::pair<int, int>>
+planar_embedding(Graph &graph, int threads = 1,
+                 PlanarityWorkspace *workspace = nullptr);
+
+/**
+ * Finds straight-line planar embedding of every connected component of a
+ * simple graph separately, on up to threads threads, and packs the drawings
+ * side by side with a shelf packer. Unlike planar_embedding, the size of the
+ * grid depends on the sizes of the components: a forest of small trees gets a
+ * grid of side O(sqrt(|V|)) instead of |V| - 2. Components with less than 3
+ * vertices are drawn as a point or a segment.
+ *
+ * Throws exception if the graph is not planar.
+ *
+ * @complexity O(|V| + |E|) work, plus O(c log c) for c components
+ * @param graph The graph.
+ * @param threads Number of threads, 0 means default_threads().
  * @return Planar embedding as vector of coordinates on the grid.
  */
 std::vector<std::pair<int, int>>
-planar_embedding(std::vector<std::list<int>> &list);
+planar_embedding_by_components(const Graph &graph, int threads = 0);
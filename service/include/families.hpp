@@ -0,0 +1,21 @@
+#pragma once
+
+#include "graph.hpp"
+#include <vector>
+
+/**
+ * Draws a graph whose every connected component is a tree or a cycle
+ * (forests, paths, cycles) directly, without the planarity test,
+ * triangulation and Schnyder wood. Components get consecutive columns: a tree
+ * is drawn with x from its DFS preorder and y its depth, rooted at a vertex
+ * of degree at least 2 if there is one, and a cycle as a path on a row closed
+ * by one vertex above its start. Graphs with more than |V| edges are rejected
+ * without a scan.
+ *
+ * @complexity O(|V| + |E|)
+ * @param graph The graph, with at least one edge and 3 vertices.
+ * @return Straight-line embedding as vector of coordinates on
+ * {0..|V|-2} x {0..|V|-2} grid, or empty vector if some component is neither
+ * a tree nor a cycle.
+ */
+std::vector<std::pair<int, int>> draw_trees_and_cycles(const Graph &graph);
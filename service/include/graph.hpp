@@ -0,0 +1,127 @@
+#pragma once
+
+#include <span>
+#include <utility>
+#include <vector>
+
+/**
+ * Graph stored in compressed sparse row format. Vertices are numbered
+ * [1, n]. Neighbours of vertex v are adj[off[v]..off[v + 1]), kept in rotation
+ * order whenever the graph represents a combinatorial embedding. If the graph
+ * is enumerated, eid[i] is the id (from [1, m]) of the edge of half-edge i.
+ */
+struct Graph {
+  int n;
+  std::vector<int> off; // n + 2 offsets, off[0] = off[1] = 0
+  std::vector<int> adj; // neighbour of each half-edge
+  std::vector<int> eid; // edge id of each half-edge, empty if not enumerated
+
+  Graph() : n(0) {}
+  Graph(int _n) : n(_n), off(_n + 2, 0) {}
+
+  // True iff the graph holds no vertex set at all (used as "not planar").
+  bool empty() const { return off.empty(); }
+
+  int half_edges() const { return adj.size(); }
+  int edges() const { return adj.size() / 2; }
+  int degree(int v) const { return off[v + 1] - off[v]; }
+
+  std::span<const int> neighbours(int v) const {
+    return {adj.data() + off[v], adj.data() + off[v + 1]};
+  }
+};
+
+/**
+ * Following Euler's formula, |E| <= 3 * |V| - 6 for all planar graphs with
+ * |V| >= 3, so a graph with more edges is not planar.
+ *
+ * @param n Number of vertices.
+ * @param m Number of edges.
+ * @return Whether n >= 3 and m > 3n - 6.
+ */
+inline bool exceeds_euler_bound(long long n, long long m) {
+  return n >= 3 && m > 3 * n - 6;
+}
+
+/**
+ * Build graph from an edge list. Neighbours of every vertex are kept in the
+ * order in which the edges appear.
+ *
+ * @complexity O(|V| + |E|)
+ * @param n Number of vertices.
+ * @param edges Undirected edges {u, v} with u, v in [1, n].
+ * @return Graph with both half-edges of every edge.
+ */
+Graph build_graph(int n, const std::vector<std::pair<int, int>> &edges);
+
+/**
+ * Build graph from a flat edge list, edge i being
+ * {endpoints[2i], endpoints[2i + 1]}. Neighbours of every vertex are kept in
+ * the order in which the edges appear.
+ *
+ * @complexity O(|V| + |E|)
+ * @param n Number of vertices.
+ * @param endpoints 2|E| endpoints from [1, n].
+ * @return Graph with both half-edges of every edge.
+ */
+Graph build_graph_flat(int n, std::span<const int> endpoints);
+
+/**
+ * Build graph from a list of directed arcs. Only arc u->v is stored, in
+ * the adjacency of u, in the order in which the arcs appear.
+ *
+ * @complexity O(|V| + |E|)
+ * @param n Number of vertices.
+ * @param arcs Arcs {u, v} with u, v in [1, n].
+ * @return Directed graph.
+ */
+Graph build_digraph(int n, const std::vector<std::pair<int, int>> &arcs);
+
+/**
+ * Append undirected edges to the graph. New neighbours are placed at the end
+ * of adjacency of both endpoints, in the order in which the edges appear.
+ * Drops edge ids.
+ *
+ * @complexity O(|V| + |E|)
+ * @param graph The graph.
+ * @param edges Edges to add.
+ */
+void append_edges(Graph &graph, const std::vector<std::pair<int, int>> &edges);
+
+/**
+ * Checks whether some edge of the graph is repeated, i.e. some vertex has the
+ * same neighbour twice.
+ *
+ * @complexity O(|V| + |E|)
+ * @param graph The graph.
+ * @return Whether the graph has multiedges.
+ */
+bool has_parallel_edges(const Graph &graph);
+
+/**
+ * Merges repeated edges into one, keeping the first occurrence of every
+ * neighbour in adjacency of every vertex. Drops edge ids if an edge is
+ * removed.
+ *
+ * @complexity O(|V| + |E|)
+ * @param graph The graph.
+ * @return Number of removed edges.
+ */
+int merge_parallel_edges(Graph &graph);
+
+/**
+ * Labels connected components with concurrent union-find over the edges, on
+ * up to threads threads. Every edge links the root with the larger id under
+ * the one with the smaller, so the root of a component ends up being its
+ * smallest vertex and components are numbered in the order of their smallest
+ * vertices, whatever the number of threads. On one thread, or on a small
+ * graph, components are labelled with BFS instead.
+ *
+ * @complexity O((|V| + |E|) log |V|) work
+ * @param graph The graph.
+ * @param component Receives component of every vertex, from [0, count).
+ * @param threads Number of threads, 0 means default_threads().
+ * @return Number of components.
+ */
+int label_components(const Graph &graph, std::vector<int> &component,
+                     int threads = 1);
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "graph.hpp"
+#include <span>
+#include <vector>
+
+/**
+ * Combinatorial embedding stored as half-edges in flat int arrays. Edge e
+ * consists of half-edges 2e and 2e + 1, so the twin of h is h ^ 1. Rotation
+ * around every vertex is a cyclic doubly linked list through next and prev,
+ * read from first like a list from its beginning: inserting before the first
+ * half-edge makes the new one first. Assumes vertices are numbered from
+ * [1, n].
+ *
+ * Faces are traced as in find_faces: after h = x->y comes face_next(h), the
+ * half-edge before y->x in rotation of y.
+ */
+struct HalfEdgeGraph {
+  int n;
+  std::vector<int> head;  // vertex the half-edge points to
+  std::vector<int> next;  // next half-edge in rotation around its tail
+  std::vector<int> prev;  // previous half-edge in rotation around its tail
+  std::vector<int> first; // first half-edge out of the vertex, -1 if none
+  std::vector<int> degree;
+
+  HalfEdgeGraph() : n(0) {}
+
+  /**
+   * Vertices with no half-edges linked yet, and edges unlinked half-edges
+   * whose heads are to be set by the caller.
+   *
+   * @complexity O(|V| + |E|)
+   * @param n Number of vertices.
+   * @param edges Number of edges.
+   */
+  HalfEdgeGraph(int n, int edges);
+
+  /**
+   * Half-edges of a combinatorial embedding. Edge e is the (e + 1)-th edge of
+   * enumerate_adjacency_list and half-edge 2e goes from its smaller endpoint.
+   *
+   * @complexity O(|V| + |E|)
+   * @param graph Graph with adjacency sorted according to the embedding.
+   */
+  explicit HalfEdgeGraph(const Graph &graph);
+
+  /**
+   * Same as HalfEdgeGraph(n, edges), reusing the buffers: allocates nothing
+   * unless they are too small.
+   *
+   * @complexity O(|V| + |E|)
+   * @param n Number of vertices.
+   * @param edges Number of edges.
+   */
+  void assign(int n, int edges);
+
+  int edges() const { return head.size() / 2; }
+  int tail(int h) const { return head[h ^ 1]; }
+  int face_next(int h) const { return prev[h ^ 1]; }
+
+  // Makes room for edges edges, so that adding them moves nothing.
+  void reserve(int edges);
+
+  // Adds edge {u, v} with unlinked half-edges u->v and v->u. Returns its id.
+  int add_edge(int u, int v);
+
+  // Links unlinked half-edge h into rotation of its tail after half-edge g,
+  // or as the only one if g is -1.
+  void insert_after(int g, int h);
+
+  // Links unlinked half-edge h into rotation of its tail before half-edge g,
+  // or as the only one if g is -1.
+  void insert_before(int g, int h);
+
+  void push_front(int h) { insert_before(first[tail(h)], h); }
+  void push_back(int h) {
+    int x = tail(h);
+    insert_after(first[x] == -1 ? -1 : prev[first[x]], h);
+  }
+
+  /**
+   * Graph with adjacency in rotation order, each read from first.
+   *
+   * @complexity O(|V| + |E|)
+   * @param enumerated Whether to fill eid, edge e getting id e + 1.
+   * @return The graph.
+   */
+  Graph to_graph(bool enumerated = false) const;
+};
+
+/**
+ * Faces of a combinatorial embedding, as found by find_faces: face f is
+ * half_edges[off[f]..off[f + 1]), in order of face_next.
+ */
+struct Faces {
+  std::vector<int> off;        // size() + 1 offsets, off[0] = 0
+  std::vector<int> half_edges; // faces one after another
+
+  int size() const { return off.size() - 1; }
+  std::span<int> operator[](int f) {
+    return {half_edges.data() + off[f], half_edges.data() + off[f + 1]};
+  }
+  std::span<const int> operator[](int f) const {
+    return {half_edges.data() + off[f], half_edges.data() + off[f + 1]};
+  }
+};
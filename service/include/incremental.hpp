@@ -0,0 +1,91 @@
+#pragma once
+
+#include "graph.hpp"
+#include "half_edge.hpp"
+#include <vector>
+
+/**
+ * Combinatorial embedding of a planar graph kept up to date while edges are
+ * inserted, together with a triangulation containing it and its straight-line
+ * drawing. Assumes vertices are numbered from [1, |V|].
+ *
+ * The embedding is stored as rotations of half-edges with the face of every
+ * half-edge, so an insertion only touches the endpoints and one face:
+ *     - an edge of the current triangulation keeps the drawing,
+ *     - an edge between vertices of a common face, or of different connected
+ *       components, is spliced into the rotations and the face is split or
+ *       merged, relabelling the new part or the smaller one,
+ *     - otherwise the planarity test is run on the whole graph again.
+ * The drawing is recomputed lazily, from the stored embedding, which skips the
+ * planarity test.
+ */
+class IncrementalEmbedding {
+  int n;
+  HalfEdgeGraph rotation;
+  std::vector<int> face;      // face traced by find_faces through the half-edge
+  std::vector<int> face_size; // number of half-edges of every face id
+  std::vector<int> component; // union-find forest of connected components
+  // Scratch, -1 outside of insert_edge: half-edge of a vertex on every face,
+  // with one entry per face id given so far, and half-edge to every vertex.
+  std::vector<int> corner, neighbour;
+
+  Graph triangulation; // containing the graph, valid iff drawn
+  std::vector<std::pair<int, int>> drawing;
+  bool drawn;
+
+  void build(const Graph &embedding);
+  int find(int v);
+  bool adjacent(int u, int v);
+  int triangulation_corner(int u, int v);
+  int label(int start, int stop, int f);
+  void splice(int u, int gu, int v, int gv);
+
+public:
+  enum class Insertion {
+    Drawn,      // edge of the triangulation, drawing is still valid
+    Patched,    // embedding changed locally, drawing will be recomputed
+    Reembedded, // embedding found again by the planarity test
+    NotPlanar   // the graph with the edge is not planar, nothing changed
+  };
+
+  /**
+   * Throws exception if the graph is not planar or has less than 3 vertices.
+   *
+   * @complexity O(|V| + |E|)
+   * @param graph The graph, without loops or multiedges.
+   */
+  explicit IncrementalEmbedding(const Graph &graph);
+
+  /**
+   * Inserts edge {u, v} if the graph stays planar. Throws exception if the
+   * edge is a loop, already exists or has an endpoint outside of [1, |V|].
+   *
+   * @complexity O(deg(u) + deg(v)) for an edge of the triangulation or
+   * between components, plus size of the split face if u and v share a face,
+   * O(|V| + |E|) otherwise.
+   * @param u First endpoint.
+   * @param v Second endpoint.
+   * @return How the edge was inserted, or NotPlanar.
+   */
+  Insertion insert_edge(int u, int v);
+
+  /**
+   * Current combinatorial embedding.
+   *
+   * @complexity O(|V| + |E|)
+   * @return Graph with adjacency sorted according to the embedding.
+   */
+  Graph embedding() const;
+
+  /**
+   * Straight-line drawing of the current graph, recomputed if an insertion
+   * invalidated it.
+   *
+   * @complexity O(1) if drawn, O(|V| + |E|) otherwise
+   * @return Coordinates of vertices on {0..|V|-2} x {0..|V|-2} grid, indexed
+   * from 1.
+   */
+  const std::vector<std::pair<int, int>> &coordinates();
+
+  int edges() const { return rotation.edges(); }
+};
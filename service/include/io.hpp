@@ -0,0 +1,103 @@
+#pragma once
+
+#include "graph.hpp"
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * Reads graph from file in format:
+ *
+ *     n m
+ *     a_1 b_1
+ *     ...
+ *     a_m b_m
+ *
+ * The file is memory-mapped and split into chunks which are parsed in
+ * parallel. Neighbours of every vertex are kept in the order of the edges in
+ * the file. Repeated edges are merged into their first occurrence, see
+ * merge_parallel_edges.
+ *
+ * Throws std::runtime_error if the file cannot be read or is malformed (not
+ * exactly 2m non-negative integers after the header, endpoints outside of
+ * [1, n] or loops), and std::invalid_argument if the graph has more than
+ * 3n - 6 edges for n >= 3 after merging, in which case it cannot be planar.
+ *
+ * @complexity O(|V| + |E|)
+ * @param path Path to the input file.
+ * @param threads Number of parsing threads, 0 means default_threads().
+ * @return The graph.
+ */
+Graph read_graph(const char *path, int threads = 0);
+
+/**
+ * Reads consecutive graphs, each in the input file format, from a file
+ * descriptor (e.g. a pipe) through a fixed buffer.
+ */
+class GraphStreamReader {
+  int fd;
+  std::vector<char> buffer;
+  size_t pos, len;
+  bool eof, broken;
+
+  bool fill();
+  bool next_span(size_t &end);
+  int next_token(int &x);
+
+public:
+  explicit GraphStreamReader(int fd);
+
+  /**
+   * Reads next graph. Returns false at the end of the stream, or if the
+   * stream is broken. Merges repeated edges and throws the same exceptions
+   * as read_graph for an invalid graph. After std::invalid_argument, or a
+   * std::runtime_error that leaves ok() true, the whole graph has been
+   * consumed and reading can go on.
+   */
+  bool read(Graph &graph);
+
+  // Consumes the next token if it is the given word. Otherwise the stream is
+  // left as it was, so a graph can still be read.
+  bool read_keyword(std::string_view word);
+
+  // False after a token which is not a non-negative integer, or a stream
+  // ending in the middle of a graph. No graph can be read after that.
+  bool ok() const { return !broken; }
+};
+
+enum class OutputFormat {
+  Text,   // "x y" line per vertex
+  Binary, // header + packed little-endian int32 arrays x[], y[]
+  Varint, // header + zigzag delta LEB128 varints of x[], then of y[]
+};
+
+/**
+ * Encodes coordinates of vertices 1..n (coords[0] is vertex 1).
+ *
+ * Binary and varint formats start with a 12 byte header:
+ *
+ *     bytes 0-3   magic "ARAE"
+ *     byte  4     version (1)
+ *     byte  5     encoding (0 = int32, 1 = varint)
+ *     bytes 6-7   reserved (0)
+ *     bytes 8-11  n as uint32 little-endian
+ *
+ * followed by the x array and then the y array. In the varint format every
+ * value is replaced by its difference to the previous value of the same
+ * array (the first one to 0), mapped to unsigned by zigzag encoding and
+ * written as LEB128.
+ *
+ * @complexity O(|V|)
+ * @param coords The coordinates.
+ * @param format Output format.
+ * @return Encoded bytes.
+ */
+std::string encode_embedding(const std::vector<std::pair<int, int>> &coords,
+                             OutputFormat format);
+
+/**
+ * Writes whole buffer to file descriptor, retrying on partial writes.
+ * Throws std::runtime_error on failure.
+ */
+void write_all(int fd, const std::string &buffer);
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <functional>
+
+/**
+ * Number of worker threads to use by default, i.e. number of hardware threads
+ * (at least 1).
+ */
+int default_threads();
+
+/**
+ * Runs body(i) for every i in [0, count) on up to threads threads. Blocks
+ * until all calls finish. Rethrows the first exception thrown by body.
+ *
+ * @param count Number of tasks.
+ * @param threads Number of threads, 0 means default_threads().
+ * @param body Task to run.
+ */
+void parallel_for(int count, int threads, const std::function<void(int)> &body);
@@ -1,28 +1,123 @@
 #pragma once
 
+#include "graph.hpp"
+#include "half_edge.hpp"
 #include "utils.hpp"
-#include <list>
+#include <cstdint>
 #include <vector>
 
+/**
+ * Buffers of is_planar and test_planarity, kept between calls. A call
+ * resizes them to its graph, so repeated calls on graphs of similar size
+ * allocate nothing but the returned embedding. The buffers keep the size of
+ * the largest graph tested; contents are meaningless between calls. One
+ * workspace serves one call at a time.
+ */
+struct PlanarityWorkspace {
+  struct Frame {
+    int v, f, i; // vertex, its parent and current half-edge
+  };
+  struct EdgeFrame {
+    int e;          // edge by which v was entered, NO_EDGE at the root
+    int v, i;       // vertex and its current half-edge
+    int low_edge;   // edge of lowest return point of e
+    int bottom;     // top of S when half-edge i was entered
+    int low_edge_i; // low_edge of half-edge i, once the search returned
+    bool returned;  // whether the search returned from half-edge i
+  };
+
+  // dfs1, in vertex numbers of the graph.
+  std::vector<int> preorder, low, low2, relabel;
+  std::vector<bool> visited;
+  std::vector<Frame> frames;
+  std::vector<std::pair<int, int>> arcs; // DFS orientation, then order B
+  // Oriented graph in preorder labels, the roots of its DFS trees and
+  // counting sort of its edges by bucket.
+  Graph list, elist;
+  std::vector<int> roots, bucket_off, pos;
+  // dfs2 and signs, by edge id: the position of the edge in elist.
+  std::vector<int> low_e, ref;
+  std::vector<int8_t> side, sign;
+  std::vector<EdgeConstraint> constraints;
+  std::vector<EdgeFrame> edge_frames;
+  // dfs3, in preorder labels.
+  HalfEdgeGraph rotation;
+  std::vector<int> left, right;
+};
+
 /** Checks whether graph is planar and returns its combinatoric
- * embedding if it is. Uses Fraysseix-Mendez-Rosenstiehl algorithm. Assumes the
- * graph is connected and has no multiedges or loops.
+ * embedding if it is. Uses Fraysseix-Mendez-Rosenstiehl algorithm. Every
+ * connected component is searched from its own root. Assumes the graph has no
+ * multiedges or loops.
+ *
+ * @complexity O(|V|)
+ * @param graph The graph.
+ * @return Graph with adjacency sorted according to combinatoric embedding if
+ * the graph is planar, empty graph otherwise.
+ */
+Graph is_planar(const Graph &graph);
+
+/** Same as is_planar(graph), with buffers from workspace.
+ *
+ * @complexity O(|V|)
+ * @param graph The graph.
+ * @param workspace Buffers reused across calls.
+ * @return Graph with adjacency sorted according to combinatoric embedding if
+ * the graph is planar, empty graph otherwise.
+ */
+Graph is_planar(const Graph &graph, PlanarityWorkspace &workspace);
+
+/** Checks whether graph is planar, without finding its embedding. Stops
+ * after dfs2 of the Fraysseix-Mendez-Rosenstiehl algorithm: signs of edges,
+ * the rotation system and the output graph are never built, which takes
+ * about half the time and memory of is_planar. Assumes the graph has no
+ * multiedges or loops.
+ *
+ * @complexity O(|V|)
+ * @param graph The graph.
+ * @return Whether the graph is planar.
+ */
+bool test_planarity(const Graph &graph);
+
+/** Same as test_planarity(graph), with buffers from workspace.
  *
  * @complexity O(|V|)
- * @param list Adjacency list of the graph
- * @return Adjacency list sorted according to combinatoric embedding if the
- * graph is planar, empty list otherwise.
+ * @param graph The graph.
+ * @param workspace Buffers reused across calls.
+ * @return Whether the graph is planar.
  */
-std::vector<std::list<int>> is_planar(std::vector<std::list<int>> list);
+bool test_planarity(const Graph &graph, PlanarityWorkspace &workspace);
 
-/** Finds planar graphs faces. Assumes the graph has no loops or
+/** Checks whether graph is planar and returns its combinatoric embedding if
+ * it is, testing biconnected components (blocks) separately. A graph is
+ * planar iff all its blocks are. Blocks are first checked against Euler's
+ * bound, then embedded by is_planar on up to threads threads. Rotation of an
+ * articulation point is the concatenation of its rotations in its blocks,
+ * which places every block in a face of the others. Assumes the graph has no
+ * multiedges or loops.
+ *
+ * @complexity O(|V| + |E|)
+ * @param graph The graph.
+ * @param threads Number of threads, 0 means default_threads().
+ * @return Graph with adjacency sorted according to combinatoric embedding if
+ * the graph is planar, empty graph otherwise.
+ */
+Graph is_planar_by_blocks(const Graph &graph, int threads = 0);
+
+/**
+ * Finds faces of a combinatorial embedding, up to threads at a time. A face
+ * is traced from its smallest half-edge, and faces are ordered by it, so the
+ * result does not depend on threads. Assumes the graph has no loops or
  * multiedges.
  *
- *  @complexity O(|V|)
- *  @param list Enumerated adjacency list of graph (combinatorial embedding).
- *  @param CR Graph edges cross references.
- *  @return vector of graph faces.
+ * Every thread scans its own range of half-edges and traces a face from
+ * each one not claimed yet, claiming half-edges with compare-and-swap until
+ * it runs into a claimed one. That one is where another trace of the face
+ * started, so the traces of a face link up into a cycle.
+ *
+ * @complexity O(|V|)
+ * @param graph Combinatorial embedding.
+ * @param threads Number of threads, 0 means default_threads().
+ * @return Faces of the graph.
  */
-std::vector<std::vector<std::pair<int, int>>>
-find_faces(std::vector<std::list<std::pair<int, int>>> &list,
-           std::vector<EdgeCrossRef> &CR);
+Faces find_faces(const HalfEdgeGraph &graph, int threads = 1);
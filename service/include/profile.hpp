@@ -0,0 +1,149 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/*
+ * Instrumentation of the embedding pipeline: wall time and allocations per
+ * stage plus counters of the algorithms. It is compiled in only with
+ * ARA_PROFILE defined (CMake option ARA_PROFILE). Otherwise the ARA_PROFILE_*
+ * macros expand to nothing. Allocations are counted only in aracli, which
+ * replaces operator new (allocation_hook.cpp); libara leaves the allocator of
+ * its host alone.
+ *
+ * Data is collected into the Profile of a Session alive on the same thread,
+ * and dropped if there is none.
+ */
+
+namespace profile {
+
+enum Counter {
+  FMR_STACK_PEAK,        // largest size of constraint stack S in dfs2
+  MERGE_ITERATIONS,      // iterations of loops in merge
+  REMOVE_ITERATIONS,     // iterations of loops in remove
+  MAKE_2CONNECTED_EDGES, // edges added by make_2connected
+  TRIANGULATE_EDGES,     // edges added by triangulate_faces
+  KERNEL_VERTICES,       // vertices left for the planarity test by reduce_graph
+  COUNTER_COUNT
+};
+
+struct Stage {
+  const char *name;
+  double ms;
+  long long allocations; // calls of operator new on the stage's thread
+  long long bytes;       // bytes requested from operator new
+};
+
+struct Profile {
+  std::vector<Stage> stages;
+  long long counters[COUNTER_COUNT] = {};
+  std::vector<long long> face_sizes; // number of faces of every size, before
+                                     // triangulation
+
+  /**
+   * Encodes the profile as
+   *
+   *     {"stages": [{"name": ..., "ms": ..., "allocations": ...,
+   *      "bytes": ...}, ...], "total_ms": ..., "counters": {...},
+   *      "face_sizes": {"<size>": <count>, ...}}
+   */
+  std::string to_json() const;
+};
+
+#ifdef ARA_PROFILE
+
+extern thread_local Profile *current;
+
+// Allocations made on this thread since it started.
+long long thread_allocations();
+long long thread_allocated_bytes();
+
+// Counts an allocation of size bytes on this thread.
+void count_allocation(size_t size);
+
+/**
+ * Makes this thread collect into the given profile, or nowhere if it is null,
+ * while alive.
+ */
+class Session {
+  Profile *previous;
+
+public:
+  explicit Session(Profile *profile) : previous(current) { current = profile; }
+  ~Session() { current = previous; }
+
+  Session(const Session &) = delete;
+  Session &operator=(const Session &) = delete;
+};
+
+/**
+ * Splits time of a sequence of stages: lap(name) records the stage which
+ * ends now and started at the previous lap, reset() or construction.
+ */
+class Laps {
+  std::chrono::steady_clock::time_point start;
+  long long allocations, bytes;
+
+public:
+  Laps() { reset(); }
+
+  void reset() {
+    start = std::chrono::steady_clock::now();
+    allocations = thread_allocations();
+    bytes = thread_allocated_bytes();
+  }
+
+  void lap(const char *name) {
+    if (current) {
+      std::chrono::duration<double, std::milli> ms =
+          std::chrono::steady_clock::now() - start;
+      current->stages.push_back({name, ms.count(),
+                                 thread_allocations() - allocations,
+                                 thread_allocated_bytes() - bytes});
+    }
+    reset();
+  }
+};
+
+inline void add(Counter counter, long long delta) {
+  if (current)
+    current->counters[counter] += delta;
+}
+
+inline void max(Counter counter, long long value) {
+  if (current && current->counters[counter] < value)
+    current->counters[counter] = value;
+}
+
+template <typename Faces> void faces(const Faces &faces) {
+  if (!current)
+    return;
+  for (int f = 0; f < faces.size(); f++) {
+    size_t size = faces[f].size();
+    if (current->face_sizes.size() <= size)
+      current->face_sizes.resize(size + 1);
+    current->face_sizes[size]++;
+  }
+}
+
+#endif
+
+} // namespace profile
+
+#ifdef ARA_PROFILE
+#define ARA_PROFILE_LAPS(laps) profile::Laps laps
+#define ARA_PROFILE_LAP(laps, name) laps.lap(name)
+#define ARA_PROFILE_RESET(laps) laps.reset()
+#define ARA_PROFILE_ADD(counter, delta) profile::add(profile::counter, delta)
+#define ARA_PROFILE_MAX(counter, value) profile::max(profile::counter, value)
+#define ARA_PROFILE_FACES(faces) profile::faces(faces)
+#else
+#define ARA_PROFILE_LAPS(laps)
+#define ARA_PROFILE_LAP(laps, name)
+#define ARA_PROFILE_RESET(laps)
+#define ARA_PROFILE_ADD(counter, delta)
+#define ARA_PROFILE_MAX(counter, value)
+#define ARA_PROFILE_FACES(faces)
+#endif
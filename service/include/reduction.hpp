@@ -0,0 +1,75 @@
+#pragma once
+
+#include "graph.hpp"
+#include "planar.hpp"
+#include <vector>
+
+/**
+ * Kernel of a graph: what is left after repeatedly removing vertices of
+ * degree at most 1 and replacing every path through vertices of degree 2
+ * (a chain) by a single edge. A chain which would become a loop or a second
+ * edge between its ends keeps one or two of its vertices. Cycles with no
+ * vertex of degree 3 or more disappear. The kernel is planar iff the graph
+ * is.
+ */
+struct Kernel {
+  Graph graph;             // vertices [1, k]
+  std::vector<int> vertex; // vertex of the graph of every kernel vertex
+  std::vector<int> via; // for half-edge v->w of graph, neighbour of vertex[v]
+                        // on the path replaced by {v, w}
+};
+
+/**
+ * Builds the kernel of a graph. Assumes the graph has no multiedges or loops.
+ *
+ * @complexity O(|V| + |E|)
+ * @param graph The graph.
+ * @return Kernel of the graph.
+ */
+Kernel reduce_graph(const Graph &graph);
+
+/**
+ * Combinatorial embedding of a graph from one of its kernel. Kernel vertices
+ * keep the rotation of the kernel, followed by their removed neighbours,
+ * other vertices keep their adjacency: a removed tree or a chain fits any
+ * corner.
+ *
+ * @complexity O(|V| + |E|)
+ * @param graph The graph.
+ * @param kernel Kernel of the graph.
+ * @param embedding Graph of the kernel with adjacency sorted according to its
+ * combinatorial embedding.
+ * @return Graph with adjacency sorted according to combinatorial embedding.
+ */
+Graph expand_embedding(const Graph &graph, const Kernel &kernel,
+                       const Graph &embedding);
+
+/**
+ * Checks whether graph is planar and returns its combinatoric embedding if
+ * it is, running the planarity test only on its kernel. Trees, pendant trees
+ * and long paths cost a linear scan instead. Graphs with less than |V| / 8
+ * vertices of degree at most 2 are tested whole. Repeated edges are merged
+ * first, the embedding is then one of the merged graph. Assumes the graph has
+ * no loops.
+ *
+ * @complexity O(|V| + |E|)
+ * @param graph The graph.
+ * @param threads Number of threads. 1 tests the kernel with is_planar,
+ * other values with is_planar_by_blocks.
+ * @param workspace Buffers of is_planar reused across calls, or nullptr.
+ * @return Graph with adjacency sorted according to combinatoric embedding if
+ * the graph is planar, empty graph otherwise.
+ */
+Graph is_planar_reduced(const Graph &graph, int threads = 1,
+                        PlanarityWorkspace *workspace = nullptr);
+
+/**
+ * Checks whether graph is planar, running test_planarity only on its kernel,
+ * like is_planar_reduced. No embedding is built. Repeated edges are merged
+ * first. Assumes the graph has no loops.
+ *
+ * @complexity O(|V| + |E|)
+ * @param graph The graph.
+ * @return Whether the graph is planar.
+ */
+bool test_planarity_reduced(const Graph &graph);
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "io.hpp"
+#include <cstddef>
+
+struct ServeOptions {
+  int threads = 0; // worker threads, 0 means default_threads()
+  OutputFormat format = OutputFormat::Text;
+  size_t max_in_flight = 0;        // requests per connection parsed but not
+                                   // answered, 0 means 64 * threads
+  size_t latency_window = 1 << 16; // latencies kept for percentiles
+};
+
+/**
+ * Serves embedding requests on a Unix domain socket until SIGINT or SIGTERM.
+ * Every connection is a stream of requests, each either a graph in the input
+ * file format or the word "stats". Requests of all connections run on one
+ * work-stealing pool. Responses come in the order of requests of the
+ * connection, indexed from 0: a graph is answered with a batch record (see
+ * encode_record) and "stats" with
+ *
+ *     <index> stats <length>\n<length bytes of JSON>
+ *
+ * holding request and error counts, open connections, requests in flight,
+ * pool queue depth and percentiles of latency (from a parsed request to its
+ * encoded response) over the last requests.
+ *
+ * A socket file at the path is replaced if it refuses connections, and
+ * removed on exit. Throws std::runtime_error if a server is already serving
+ * at the path.
+ *
+ * @param socket_path Path of the socket.
+ * @param options Server options.
+ */
+void run_server(const char *socket_path, const ServeOptions &options);
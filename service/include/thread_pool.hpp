@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Work-stealing thread pool. Every worker owns a deque of tasks: it takes
+ * tasks from the back of its own deque and, when it runs empty, steals from
+ * the front of the others. Tasks submitted from a worker go to its own deque,
+ * tasks submitted from outside are spread round-robin.
+ */
+class ThreadPool {
+  struct Queue {
+    std::mutex m;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> workers;
+  std::atomic<unsigned> next_queue;
+
+  std::mutex m;
+  std::condition_variable work_cv; // signalled when a task is queued
+  std::condition_variable idle_cv; // signalled when a task finishes
+  size_t queued;                   // tasks in deques
+  size_t unfinished;               // tasks queued or running
+  bool stop;
+
+  bool try_pop(int self, std::function<void()> &task);
+  void run(int self);
+
+public:
+  /**
+   * Starts the workers.
+   *
+   * @param threads Number of workers, 0 means default_threads().
+   */
+  explicit ThreadPool(int threads = 0);
+
+  // Waits for all tasks and joins the workers.
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  int size() const { return workers.size(); }
+
+  // Number of tasks waiting for a worker.
+  size_t queue_depth();
+
+  // Queues task. Tasks must not throw.
+  void submit(std::function<void()> task);
+
+  // Blocks until all submitted tasks finish.
+  void wait();
+};
@@ -1,35 +1,37 @@
 #pragma once
 
-#include <list>
+#include "graph.hpp"
+#include "half_edge.hpp"
 #include <vector>
 
 /**
  * Returns combinational embedding of given planar graphs triangulation.
- * Does not assume the graph is connected. Assumes the provided adjacency list
+ * Does not assume the graph is connected. Assumes the provided graph
  * corresponds to a planar combinational embedding of the graph and that the
  * graph has at least 3 vertices and is loop-free and multiedge-free. The
  * algorithm first makes the graph connected, then 2-connected and at the end,
- * triangulates all faces.
+ * triangulates all faces, up to threads at a time. The triangulation does not
+ * depend on threads.
  *
  * @complexity O(|V|)
- * @param list Adjacency list of the graph (sorted according to combinational
+ * @param graph The graph (adjacency sorted according to combinational
  * embedding)
- * @return Adjacency list of graph triangulation
+ * @param threads Number of threads labelling components and triangulating
+ * faces, 0 means default_threads().
+ * @return Graph triangulation
  */
-std::vector<std::list<int>> get_triangulation(std::vector<std::list<int>> list);
+Graph get_triangulation(const Graph &graph, int threads = 1);
 
 /**
  * Returns Schnyder wood for given planar triangulation graph and set outer
  * face f = {a, b, c}. c will be 0-root, a will be 2-root, b will be 1-root.
  *
  * @complexity O(|V|)
- * @param list Adjacency list of given graph. Assumes edges v-u in list[v] are
- * represented by pairs {u, id}, where id \in [1..m]
- * @return vector v such that v[edge_id] = {dir, color} and:
+ * @param graph Combinatorial embedding of the triangulation.
+ * @return vector v such that v[e] = {dir, color} for edge e and:
  *     - dir = -1 if the edge is directed towards vertex with smaller id, 1
  * otherwise,
  *     - color \in {0, 1, 2} represents the edge color.
  */
-std::vector<std::pair<int, int>>
-get_schnyder_wood(std::vector<std::list<std::pair<int, int>>> &list, int a,
-                  int b, int c);
+std::vector<std::pair<int, int>> get_schnyder_wood(const HalfEdgeGraph &graph,
+                                                   int a, int b, int c);
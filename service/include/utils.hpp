@@ -1,6 +1,8 @@
 #pragma once
 
-#include <list>
+#include "graph.hpp"
+#include <deque>
+#include <memory_resource>
 #include <stack>
 #include <vector>
 
@@ -8,46 +10,31 @@
 
 const int INF = 1e9;
 
-// An edge with id.
-struct EnumEdge {
-  int a, b, id;
-  EnumEdge() { *this = empty(); }
-  EnumEdge(int _a, int _b, int _id) : a(_a), b(_b), id(_id) {}
-  bool is_empty() { return id == -1; }
-  static EnumEdge empty();
-};
+// Edge id of the planarity test standing for no edge.
+const int NO_EDGE = -1;
 
+// Range of edge ids, empty if low is NO_EDGE.
 struct EdgeRange {
-  EnumEdge low, high;
+  int low, high;
 
-  EdgeRange() : low(EnumEdge::empty()), high(EnumEdge::empty()){};
-  EdgeRange(EnumEdge _low, EnumEdge _high) : low(_low), high(_high){};
+  EdgeRange() : low(NO_EDGE), high(NO_EDGE){};
+  EdgeRange(int _low, int _high) : low(_low), high(_high){};
 
-  bool is_empty() { return low.is_empty(); }
+  bool is_empty() const { return low == NO_EDGE; }
 };
 
 /**
  * Auxiliary struct representing edge constaint in FMR planarity test
- * algorithm. Consists of two EdgeRanges with left-edges and right-edges
+ * algorithm. Consists of two EdgeRanges with left-edges and right-edges, 16
+ * bytes in all.
  */
 struct EdgeConstraint {
   EdgeRange L, R;
 
   EdgeConstraint() : L(), R(){};
-  EdgeConstraint(EnumEdge A, EnumEdge B, EnumEdge C, EnumEdge D)
-      : L(A, B), R(C, D){};
+  EdgeConstraint(int A, int B, int C, int D) : L(A, B), R(C, D){};
 
-  bool is_empty() { return L.is_empty() && R.is_empty(); }
-};
-
-struct EdgeCrossRef {
-  typedef std::list<std::pair<int, int>>::iterator list_it;
-  list_it it1, it2;
-
-  EdgeCrossRef() {}
-  EdgeCrossRef(list_it _it1, list_it _it2) : it1(_it1), it2(_it2) {}
-
-  list_it getCrossRef(int u) { return (it1->first == u) ? it1 : it2; }
+  bool is_empty() const { return L.is_empty() && R.is_empty(); }
 };
 
 /**
@@ -73,63 +60,63 @@ void sort_adjacency_list(std::vector<std::vector<int>> &list,
  * Renumerate vertices of the graph according to function phi.
  *
  * @complexity O(|V| + |E|)
- * @param list Adjacency list of the graph G.
+ * @param graph The graph G.
  * @param phi Function [n] -> [n] according to which the enumeration should be
  * performed
  */
-void renumerate(std::vector<std::list<int>> &list, std::vector<int> &phi);
+void renumerate(Graph &graph, std::vector<int> &phi);
 
 /**
- * Enumerate edges with ids [1, m] from adjacency list maintaining vertices
- * order in each list.
+ * Enumerate edges with ids [1, m] maintaining vertices order in each
+ * adjacency.
  *
  * @complexity O(|V| + |E|)
- * @param list adjacency list to enumerate.
- * @return enumerated adjacency list.
+ * @param graph graph to enumerate.
+ * @return enumerated graph (eid filled).
  */
-std::vector<std::list<std::pair<int, int>>>
-enumerate_adjacency_list(const std::vector<std::list<int>> &list);
+Graph enumerate_adjacency_list(const Graph &graph);
 
 /**
- * Build edge cross-references.
+ * Find twin of every half-edge, i.e. position of half-edge v->u for
+ * half-edge u->v.
  *
  * @complexity O(|V| + |E|)
- * @param elist enumerated adjacency list.
- * @param M max edge id. If equal to 0, assumed to be |E|.
- * @return vector of cross edge references.
+ * @param graph enumerated graph.
+ * @return vector twin such that twin[i] is the position of reverse of i.
  */
-std::vector<EdgeCrossRef>
-getEdgeCrossReferences(std::vector<std::list<std::pair<int, int>>> &elist,
-                       int M = 0);
+std::vector<int> get_twins(const Graph &graph);
 
 inline int dir(int u, int v) { return (u < v) ? 1 : -1; };
 
 /**
  * Structure calculating bridges, articulation points and biconnected components
  * partition in O(|V| + |E|) time. Assumes vertices are numbered from [1, |V|]
- * and edges are numbered [1, |E|].
+ * and edges are numbered [1, |E|]. Every connected component is searched from
+ * its own root.
  */
 class GraphConnectivity {
-  std::stack<int> S;
+  std::stack<int, std::pmr::deque<int>> S;
   std::vector<bool> visited;
   std::vector<int> preorder;
   std::vector<int> low;
   int t;
   int next_bcid;
 
-  void dfs(int v, int parent_edge);
+  void dfs(int root);
 
 public:
   int n, m;
-  std::vector<std::list<std::pair<int, int>>>
-      list;                   // adjacency list as pairs {vertex, edge_id}
+  Graph graph;                // enumerated graph
   std::vector<int> p_edge_id; // id of edge to parent in dfs tree
   std::vector<bool> bridge;   // true iff edge is a bridge
   std::vector<bool> art;      // true iff vertex is an articulation point
   std::vector<int> bcid;      // biconnected component id of edge
 
-  GraphConnectivity(std::vector<std::list<std::pair<int, int>>> _list);
+  GraphConnectivity(Graph _graph);
 
   // Returns articulation points in increasing preorder.
   std::vector<int> getArticulationPoints();
+
+  // Number of biconnected components, their ids are [1, count].
+  int getBlockCount() const { return next_bcid - 1; }
 };
@@ -9,3 +9,5 @@ make
 cd ..
 
 sudo cp ./build/main /usr/bin/aracli
+sudo cp ./build/libara.so ./build/libara.a /usr/lib/
+sudo cp ./include/ara.h /usr/include/
@@ -0,0 +1,89 @@
+#include "profile.hpp"
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+/*
+ * Counting replacements of the global allocation functions, linked only into
+ * aracli, see CMakeLists.txt: a program linking libara keeps its own
+ * allocator. Every form is replaced, so that memory is always freed by the
+ * allocator which gave it.
+ */
+
+#ifdef ARA_PROFILE
+
+namespace {
+
+void *allocate(size_t size, size_t alignment = 0) {
+  profile::count_allocation(size);
+  if (size == 0)
+    size = 1;
+  if (alignment <= alignof(std::max_align_t))
+    return std::malloc(size);
+  // aligned_alloc wants a multiple of the alignment.
+  return std::aligned_alloc(alignment,
+                            (size + alignment - 1) / alignment * alignment);
+}
+
+void *allocate_or_throw(size_t size, size_t alignment = 0) {
+  if (void *p = allocate(size, alignment))
+    return p;
+  throw std::bad_alloc();
+}
+
+} // namespace
+
+void *operator new(size_t size) { return allocate_or_throw(size); }
+void *operator new[](size_t size) { return allocate_or_throw(size); }
+void *operator new(size_t size, std::align_val_t al) {
+  return allocate_or_throw(size, (size_t)al);
+}
+void *operator new[](size_t size, std::align_val_t al) {
+  return allocate_or_throw(size, (size_t)al);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  return allocate(size);
+}
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+  return allocate(size);
+}
+void *operator new(size_t size, std::align_val_t al,
+                   const std::nothrow_t &) noexcept {
+  return allocate(size, (size_t)al);
+}
+void *operator new[](size_t size, std::align_val_t al,
+                     const std::nothrow_t &) noexcept {
+  return allocate(size, (size_t)al);
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+  std::free(ptr);
+}
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+  std::free(ptr);
+}
+void operator delete(void *ptr, std::align_val_t,
+                     const std::nothrow_t &) noexcept {
+  std::free(ptr);
+}
+void operator delete[](void *ptr, std::align_val_t,
+                       const std::nothrow_t &) noexcept {
+  std::free(ptr);
+}
+
+#endif
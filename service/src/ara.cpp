@@ -0,0 +1,135 @@
+#include "ara.h"
+#include "embedding.hpp"
+#include "graph.hpp"
+#include "planar.hpp"
+#include "reduction.hpp"
+#include "triangulation.hpp"
+#include <algorithm>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+/**
+ * Builds graph from caller's edge array, checking what the C interface
+ * promises to check. Repeated edges are merged.
+ */
+ara_status to_graph(int32_t n, const int32_t *edges, int32_t m, Graph &graph) {
+  if (n < 0 || m < 0 || (m > 0 && !edges))
+    return ARA_INVALID_ARGUMENT;
+
+  std::span<const int32_t> endpoints(edges, 2 * (size_t)m);
+  for (size_t i = 0; i < endpoints.size(); i += 2) {
+    int u = endpoints[i], v = endpoints[i + 1];
+    if (u < 1 || u > n || v < 1 || v > n || u == v)
+      return ARA_INVALID_ARGUMENT;
+  }
+
+  // A repeated edge would break the pipeline, which assumes a simple graph.
+  graph = build_graph_flat(n, endpoints);
+  merge_parallel_edges(graph);
+  if (exceeds_euler_bound(n, graph.edges()))
+    return ARA_NOT_PLANAR;
+  return ARA_OK;
+}
+
+// Runs f, turning exceptions into statuses.
+template <typename F> ara_status guarded(F f) {
+  try {
+    return f();
+  } catch (const std::invalid_argument &) {
+    return ARA_NOT_PLANAR;
+  } catch (...) {
+    return ARA_INTERNAL_ERROR;
+  }
+}
+
+} // namespace
+
+const char *ara_status_message(ara_status status) {
+  switch (status) {
+  case ARA_OK:
+    return "OK.";
+  case ARA_NOT_PLANAR:
+    return "The graph is not planar.";
+  case ARA_INVALID_ARGUMENT:
+    return "Invalid argument: bad size, edge endpoint outside of [1, n] or "
+           "loop.";
+  case ARA_INTERNAL_ERROR:
+    return "Internal error.";
+  }
+  return "Unknown status.";
+}
+
+ara_status ara_is_planar(int32_t n, const int32_t *edges, int32_t m,
+                         int32_t *offsets, int32_t *rotation) {
+  return guarded([&]() {
+    Graph graph;
+    ara_status status = to_graph(n, edges, m, graph);
+    if (status != ARA_OK || n == 0)
+      return status;
+
+    if (!offsets && !rotation)
+      return test_planarity_reduced(graph) ? ARA_OK : ARA_NOT_PLANAR;
+
+    Graph embedding = is_planar(graph);
+    if (embedding.empty())
+      return ARA_NOT_PLANAR;
+
+    if (offsets)
+      std::copy(embedding.off.begin() + 1, embedding.off.end(), offsets);
+    if (rotation)
+      std::copy(embedding.adj.begin(), embedding.adj.end(), rotation);
+    return ARA_OK;
+  });
+}
+
+ara_status ara_get_triangulation(int32_t n, const int32_t *edges, int32_t m,
+                                 int32_t *triangulation) {
+  return guarded([&]() {
+    if (n < 3 || !triangulation)
+      return ARA_INVALID_ARGUMENT;
+    Graph graph;
+    ara_status status = to_graph(n, edges, m, graph);
+    if (status != ARA_OK)
+      return status;
+
+    Graph embedding = is_planar(graph);
+    if (embedding.empty())
+      return ARA_NOT_PLANAR;
+
+    Graph result = get_triangulation(embedding);
+    if (result.edges() != 3 * n - 6)
+      return ARA_INTERNAL_ERROR;
+
+    int32_t *out = triangulation;
+    for (int v = 1; v <= n; v++)
+      for (int u : result.neighbours(v))
+        if (v < u) {
+          *out++ = v;
+          *out++ = u;
+        }
+    return ARA_OK;
+  });
+}
+
+ara_status ara_planar_embedding(int32_t n, const int32_t *edges, int32_t m,
+                                int32_t *x, int32_t *y) {
+  return guarded([&]() {
+    if (n < 3 || !x || !y)
+      return ARA_INVALID_ARGUMENT;
+    Graph graph;
+    ara_status status = to_graph(n, edges, m, graph);
+    if (status != ARA_OK)
+      return status;
+
+    std::vector<std::pair<int, int>> coords = planar_embedding(graph);
+    for (int v = 1; v <= n; v++) {
+      x[v - 1] = coords[v].first;
+      y[v - 1] = coords[v].second;
+    }
+    return ARA_OK;
+  });
+}
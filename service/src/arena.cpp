@@ -0,0 +1,19 @@
+#include "arena.hpp"
+
+namespace arena {
+
+static thread_local std::pmr::memory_resource *current = nullptr;
+
+std::pmr::memory_resource *resource() {
+  return current ? current : std::pmr::get_default_resource();
+}
+
+Scope::Scope(size_t initial_size)
+    : buffer(initial_size, std::pmr::new_delete_resource()),
+      previous(current) {
+  current = &buffer;
+}
+
+Scope::~Scope() { current = previous; }
+
+} // namespace arena
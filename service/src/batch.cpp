@@ -0,0 +1,166 @@
+#include "batch.hpp"
+#include "embedding.hpp"
+#include "graph.hpp"
+#include "io.hpp"
+#include "parallel.hpp"
+#include "planar.hpp"
+#include "thread_pool.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+std::string encode_record(long long index,
+                          const std::vector<std::pair<int, int>> &embedding,
+                          OutputFormat format) {
+  std::string payload = encode_embedding(embedding, format);
+  return std::to_string(index) + " ok " + std::to_string(payload.size()) +
+         "\n" + payload;
+}
+
+std::string encode_error_record(long long index, const std::string &message) {
+  return std::to_string(index) + " error " + message + "\n";
+}
+
+RecordSink::RecordSink(int _fd, bool _ordered, size_t _max_in_flight,
+                       bool _background)
+    : fd(_fd), ordered(_ordered), background(_background),
+      max_in_flight(_max_in_flight), failed(false), closed(false),
+      in_flight(0), ready_count(0), next_index(0) {}
+
+void RecordSink::acquire() {
+  std::unique_lock<std::mutex> lock(m);
+  cv.wait(lock, [&] { return in_flight < max_in_flight; });
+  in_flight++;
+}
+
+bool RecordSink::ok() {
+  std::lock_guard<std::mutex> lock(m);
+  return !failed;
+}
+
+void RecordSink::write(const std::string &out) {
+  if (out.empty() || failed)
+    return;
+  try {
+    write_all(fd, out);
+  } catch (const std::runtime_error &) {
+    failed = true;
+  }
+}
+
+void RecordSink::put(long long index, std::string record) {
+  std::lock_guard<std::mutex> lock(m);
+  if (!ordered) {
+    ready += record;
+    ready_count++;
+  } else {
+    pending.emplace(index, std::move(record));
+    while (!pending.empty() && pending.begin()->first == next_index) {
+      ready += pending.begin()->second;
+      pending.erase(pending.begin());
+      next_index++;
+      ready_count++;
+    }
+  }
+  if (!background) {
+    write(ready);
+    ready.clear();
+    in_flight -= ready_count;
+    ready_count = 0;
+  }
+  cv.notify_all();
+}
+
+void RecordSink::write_loop() {
+  std::unique_lock<std::mutex> lock(m);
+  while (true) {
+    cv.wait(lock, [&] { return ready_count > 0 || closed; });
+    if (ready_count == 0)
+      return;
+
+    std::string out = std::move(ready);
+    size_t count = ready_count;
+    ready.clear();
+    ready_count = 0;
+
+    lock.unlock();
+    write(out);
+    lock.lock();
+    in_flight -= count;
+    cv.notify_all();
+  }
+}
+
+void RecordSink::close() {
+  std::lock_guard<std::mutex> lock(m);
+  closed = true;
+  cv.notify_all();
+}
+
+void RecordSink::drain() {
+  std::unique_lock<std::mutex> lock(m);
+  cv.wait(lock, [&] { return in_flight == 0; });
+}
+
+bool embed_record(long long index, Graph &graph, OutputFormat format,
+                  std::string &record) {
+  // Workers of batches and servers live long, so each keeps the buffers of
+  // the planarity test between graphs.
+  thread_local PlanarityWorkspace workspace;
+  try {
+    std::vector<std::pair<int, int>> embedding =
+        planar_embedding(graph, 1, &workspace);
+    embedding.erase(embedding.begin());
+    record = encode_record(index, embedding, format);
+    return true;
+  } catch (const std::exception &e) {
+    record = encode_error_record(index, e.what());
+    return false;
+  }
+}
+
+long long run_batch(int in_fd, int out_fd, const BatchOptions &options) {
+  int threads = options.threads > 0 ? options.threads : default_threads();
+  size_t max_in_flight =
+      options.max_in_flight > 0 ? options.max_in_flight : 64 * threads;
+
+  GraphStreamReader reader(in_fd);
+  RecordSink sink(out_fd, options.ordered, max_in_flight);
+  std::atomic<long long> errors(0);
+
+  {
+    ThreadPool pool(threads);
+
+    for (long long index = 0; sink.ok(); index++) {
+      sink.acquire();
+
+      auto graph = std::make_shared<Graph>();
+      try {
+        if (!reader.read(*graph)) {
+          sink.put(index, ""); // release the slot
+          break;
+        }
+      } catch (const std::exception &e) {
+        errors++;
+        sink.put(index, encode_error_record(index, e.what()));
+        if (!reader.ok())
+          break;
+        continue;
+      }
+
+      pool.submit([&, graph, index]() {
+        std::string record;
+        if (!embed_record(index, *graph, options.format, record))
+          errors++;
+        sink.put(index, std::move(record));
+      });
+    }
+  }
+
+  return errors;
+}
@@ -0,0 +1,345 @@
+#include "cache.hpp"
+#include "embedding.hpp"
+#include "families.hpp"
+#include "graph.hpp"
+#include "io.hpp"
+#include "profile.hpp"
+#include "reduction.hpp"
+#include "triangulation.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+/*
+ * Layout of a cache file, all integers in host byte order:
+ *
+ *     Header
+ *     int32 x, y of vertices 1..n
+ *     int32 off[n + 2], adj[2m]   rotation system
+ *     int32 off[n + 2], adj[t]    triangulation with t half-edges
+ *
+ * A graph which is not planar has only the header and its adjacency, in
+ * place of the rotation system. Keys can collide, so a hit is taken only if
+ * the stored edges are those of the graph.
+ */
+struct Header {
+  char magic[4];    // "ARAC"
+  uint32_t version; // 2
+  uint64_t hi, lo;  // key of the graph
+  int32_t n, m;
+  int32_t planar;
+  int32_t triangulation_half_edges;
+};
+static_assert(sizeof(Header) == 40);
+
+const char MAGIC[4] = {'A', 'R', 'A', 'C'};
+
+size_t file_size(const Header &h) {
+  size_t adjacency = sizeof(int32_t) * ((h.n + 2ll) + 2ll * h.m);
+  if (!h.planar)
+    return sizeof(Header) + adjacency;
+  return sizeof(Header) + adjacency +
+         sizeof(int32_t) *
+             (2ll * h.n + (h.n + 2ll) + h.triangulation_half_edges);
+}
+
+/* Whether adjacency off[0..n + 1], adj[0..off[n + 1]) read from a file has
+ * exactly the edges of the simple graph. */
+bool same_edges(const Graph &graph, const int32_t *off, const int32_t *adj) {
+  int n = graph.n;
+  // Equal degrees from off[1] = 0 on make the offsets equal too, so adj is
+  // read within its bounds.
+  if (off[1] != 0)
+    return false;
+  for (int v = 1; v <= n; v++)
+    if (off[v + 1] - off[v] != graph.degree(v))
+      return false;
+
+  // mark[u] == v iff u is a neighbour of v not seen in adj yet.
+  std::vector<int> mark(n + 1, 0);
+  for (int v = 1; v <= n; v++) {
+    for (auto u : graph.neighbours(v))
+      mark[u] = v;
+    for (int i = off[v]; i < off[v + 1]; i++) {
+      int u = adj[i];
+      if (u < 1 || u > n || mark[u] != v)
+        return false;
+      mark[u] = -v;
+    }
+  }
+  return true;
+}
+
+// splitmix64 finalizer.
+uint64_t mix(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ull;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+template <typename T>
+void append(std::string &buffer, const T *data, size_t count) {
+  buffer.append((const char *)data, count * sizeof(T));
+}
+
+} // namespace
+
+std::string GraphKey::hex() const {
+  static const char digits[] = "0123456789abcdef";
+  std::string s(32, '0');
+  for (int i = 0; i < 16; i++) {
+    s[15 - i] = digits[(hi >> (4 * i)) & 15];
+    s[31 - i] = digits[(lo >> (4 * i)) & 15];
+  }
+  return s;
+}
+
+/**
+ * Computes content address of the graph. Edges are hashed one by one and the
+ * hashes are summed, so the key does not depend on the order of edges or of
+ * their endpoints, without sorting. It is not collision-resistant.
+ *
+ * @complexity O(|V| + |E|)
+ * @param graph The graph.
+ * @return Key of the graph.
+ */
+GraphKey graph_key(const Graph &graph) {
+  uint64_t hi = 0, lo = 0;
+  for (int v = 1; v <= graph.n; v++)
+    for (auto u : graph.neighbours(v))
+      if (v < u) {
+        uint64_t edge = ((uint64_t)v << 32) | (uint32_t)u;
+        hi += mix(edge);
+        lo += mix(edge ^ 0x6a09e667f3bcc909ull);
+      }
+  return {mix(hi ^ mix(graph.n)), mix(lo + (uint64_t)graph.n)};
+}
+
+/**
+ * Creates the directory if needed. Throws std::runtime_error if it cannot
+ * be created.
+ *
+ * @param directory Cache directory.
+ * @param max_bytes Limit of the total size of entries.
+ */
+ResultCache::ResultCache(std::string _directory, long long _max_bytes)
+    : directory(std::move(_directory)), max_bytes(_max_bytes) {
+  if (mkdir(directory.c_str(), 0755) == -1 && errno != EEXIST)
+    throw std::runtime_error("Failed to create cache directory.");
+}
+
+std::string ResultCache::path(const GraphKey &key) const {
+  return directory + "/" + key.hex() + ".ara";
+}
+
+/* Reads coordinates of the graph from its file, if there is a valid one, and
+ * marks it as recently used. Throws std::invalid_argument if the graph is
+ * recorded as not planar. */
+bool ResultCache::lookup(const GraphKey &key, const Graph &graph,
+                         std::vector<std::pair<int, int>> &coords) const {
+  int fd = open(path(key).c_str(), O_RDONLY);
+  if (fd == -1)
+    return false;
+
+  struct stat st;
+  void *data = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(Header))
+    data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    close(fd);
+    return false;
+  }
+
+  Header h;
+  std::memcpy(&h, data, sizeof(Header));
+  bool valid = std::memcmp(h.magic, MAGIC, 4) == 0 && h.version == 2 &&
+               h.hi == key.hi && h.lo == key.lo && h.n == graph.n &&
+               h.m == graph.edges() && file_size(h) == (size_t)st.st_size;
+  const int32_t *xy = (const int32_t *)((const char *)data + sizeof(Header));
+  if (valid) {
+    const int32_t *off = xy + (h.planar ? 2 * h.n : 0);
+    valid = same_edges(graph, off, off + h.n + 2);
+  }
+  if (valid && h.planar) {
+    coords.assign(h.n + 1, {-1, -1});
+    for (int v = 1; v <= h.n; v++)
+      coords[v] = {xy[2 * v - 2], xy[2 * v - 1]};
+  }
+  if (valid)
+    futimens(fd, nullptr); // least recently used entries are evicted first
+
+  munmap(data, st.st_size);
+  close(fd);
+
+  if (valid && !h.planar)
+    throw std::invalid_argument("The graph is not planar.");
+  return valid;
+}
+
+/* Writes the file of the graph, with an empty embedding meaning that it is
+ * not planar, then evicts old files if the cache is over its limit. */
+void ResultCache::store(const GraphKey &key, const Graph &graph,
+                        const Graph &embedding, const Graph &triangulation,
+                        const std::vector<std::pair<int, int>> &coords) const {
+  Header h;
+  std::memcpy(h.magic, MAGIC, 4);
+  h.version = 2;
+  h.hi = key.hi;
+  h.lo = key.lo;
+  h.n = graph.n;
+  h.m = graph.edges();
+  h.planar = !embedding.empty();
+  h.triangulation_half_edges = triangulation.half_edges();
+  if ((long long)file_size(h) > max_bytes)
+    return;
+
+  std::string buffer;
+  buffer.reserve(file_size(h));
+  append(buffer, &h, 1);
+  if (h.planar) {
+    append(buffer, coords.data() + 1, h.n);
+    append(buffer, embedding.off.data(), embedding.off.size());
+    append(buffer, embedding.adj.data(), embedding.adj.size());
+    append(buffer, triangulation.off.data(), triangulation.off.size());
+    append(buffer, triangulation.adj.data(), triangulation.adj.size());
+  } else {
+    append(buffer, graph.off.data(), graph.off.size());
+    append(buffer, graph.adj.data(), graph.adj.size());
+  }
+
+  // Readers never see a partial file: it is renamed into place when complete.
+  std::string temporary = directory + "/." + key.hex() + ".XXXXXX";
+  int fd = mkstemp(temporary.data());
+  if (fd == -1)
+    return;
+  bool written = true;
+  try {
+    fchmod(fd, 0644);
+    write_all(fd, buffer);
+  } catch (const std::runtime_error &) {
+    written = false;
+  }
+  close(fd);
+  if (!written || rename(temporary.c_str(), path(key).c_str()) == -1) {
+    unlink(temporary.c_str());
+    return;
+  }
+
+  evict();
+}
+
+/* Removes least recently used files until the total size of entries fits the
+ * limit, and temporary files left for over an hour by crashed writers. Files
+ * removed by another process in the meantime are skipped. */
+void ResultCache::evict() const {
+  DIR *dir = opendir(directory.c_str());
+  if (!dir)
+    return;
+
+  struct Entry {
+    struct timespec mtime;
+    long long size;
+    std::string name;
+  };
+  std::vector<Entry> entries;
+  long long total = 0;
+  time_t now = time(nullptr);
+
+  while (struct dirent *e = readdir(dir)) {
+    std::string name = e->d_name;
+    struct stat st;
+    if (name == "." || name == ".." ||
+        fstatat(dirfd(dir), e->d_name, &st, 0) == -1 || !S_ISREG(st.st_mode))
+      continue;
+    if (name[0] == '.') {
+      if (now - st.st_mtime > 3600)
+        unlinkat(dirfd(dir), e->d_name, 0);
+    } else if (name.size() > 4 &&
+               name.compare(name.size() - 4, 4, ".ara") == 0) {
+      entries.push_back({st.st_mtim, (long long)st.st_size, name});
+      total += st.st_size;
+    }
+  }
+
+  if (total > max_bytes) {
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry &a, const Entry &b) {
+                if (a.mtime.tv_sec != b.mtime.tv_sec)
+                  return a.mtime.tv_sec < b.mtime.tv_sec;
+                return a.mtime.tv_nsec < b.mtime.tv_nsec;
+              });
+    for (auto &entry : entries) {
+      if (total <= max_bytes)
+        break;
+      if (unlinkat(dirfd(dir), entry.name.c_str(), 0) == 0 || errno == ENOENT)
+        total -= entry.size;
+    }
+  }
+
+  closedir(dir);
+}
+
+/**
+ * Same as planar_embedding, but answered from the cache if the graph, up to
+ * the order of edges, was embedded before. Repeated edges are merged first.
+ * Forests and disjoint cycles are drawn directly and not stored. Throws
+ * exception if the graph is not planar or has less than 3 vertices.
+ *
+ * @complexity O(|V| + |E|), without the planarity test on a hit
+ * @param graph The graph.
+ * @param threads Number of threads testing planarity, triangulating and
+ * drawing, see planar_embedding.
+ * @return Planar embedding as vector of coordinates on the grid.
+ */
+std::vector<std::pair<int, int>>
+ResultCache::planar_embedding(const Graph &graph, int threads) const {
+  if (graph.n < 3)
+    throw std::invalid_argument("The graph has less than 3 vertices.");
+  if (has_parallel_edges(graph)) {
+    Graph simple = graph;
+    merge_parallel_edges(simple);
+    return planar_embedding(simple, threads);
+  }
+
+  ARA_PROFILE_LAPS(laps);
+  // Cheaper to draw again than to hash and look up.
+  std::vector<std::pair<int, int>> coords = draw_trees_and_cycles(graph);
+  ARA_PROFILE_LAP(laps, "trees_and_cycles");
+  if (!coords.empty())
+    return coords;
+
+  GraphKey key = graph_key(graph);
+  bool hit = lookup(key, graph, coords);
+  ARA_PROFILE_LAP(laps, "cache_lookup");
+  if (hit)
+    return coords;
+
+  Graph embedding = is_planar_reduced(graph, threads);
+  ARA_PROFILE_RESET(laps); // is_planar_reduced records its own stages
+  if (embedding.empty()) {
+    store(key, graph, embedding, Graph(), coords);
+    throw std::invalid_argument("The graph is not planar.");
+  }
+
+  Graph triangulation = get_triangulation(embedding, threads);
+  ARA_PROFILE_LAP(laps, "get_triangulation");
+  coords = draw_triangulation(triangulation, threads);
+
+  ARA_PROFILE_RESET(laps); // draw_triangulation records its own stages
+  store(key, graph, embedding, triangulation, coords);
+  ARA_PROFILE_LAP(laps, "cache_store");
+
+  return coords;
+}
@@ -1,49 +1,62 @@
+#include <algorithm>
 #include <assert.h>
-#include <list>
+#include <cmath>
 #include <stdexcept>
 #include <vector>
 
-#include "planar.hpp"
+#include "arena.hpp"
+#include "embedding.hpp"
+#include "families.hpp"
+#include "graph.hpp"
+#include "half_edge.hpp"
+#include "parallel.hpp"
+#include "profile.hpp"
+#include "reduction.hpp"
 #include "triangulation.hpp"
 #include "utils.hpp"
 
-// DFS for calculating p[] and t[] values in T_i.
-void dfs_pt(int v, int i,
-            const std::vector<std::list<std::pair<int, int>>> &elist,
-            const std::vector<std::pair<int, int>> &SW,
-            std::vector<std::vector<int>> &p,
-            std::vector<std::vector<int>> &t) {
-  t[i][v] = 1;
-  for (auto &[u, id] : elist[v]) {
-    auto [d, color] = SW[id];
-    bool isDirectedToV = (dir(u, v) == d);
-    if (color == i && isDirectedToV) {
-      p[i][u] = p[i][v] + 1;
-      dfs_pt(u, i, elist, SW, p, t);
-      t[i][v] += t[i][u];
-    }
-  }
-}
+/* Euler tour of T_i, the tree of parents parent[v] (0 if none) rooted at
+ * root: v when the tour enters v and ~v when it leaves it. Sets p[v] to the
+ * number of vertices on path from v to root and t[v] to size of subtree of v,
+ * for vertices of T_i. */
+std::vector<int> euler_tour(int root, const int *parent, int n, int *p,
+                            int *t) {
+  // Children of every vertex, grouped by parent.
+  std::vector<int> off(n + 2, 0), children(n);
+  for (int v = 1; v <= n; v++)
+    off[parent[v] + 1]++;
+  for (int v = 1; v <= n + 1; v++)
+    off[v] += off[v - 1];
+  std::vector<int> pos(off.begin(), off.end() - 1);
+  for (int v = 1; v <= n; v++)
+    if (parent[v] != 0)
+      children[pos[parent[v]]++] = v;
 
-// Dfs for calculating r[] values in T_i. ST = \sum t[v] on path from root.
-void dfs_r(int v, int i,
-           const std::vector<std::list<std::pair<int, int>>> &elist,
-           const std::vector<std::pair<int, int>> &SW,
-           std::vector<std::vector<int>> &t, std::vector<std::vector<int>> &r,
-           std::vector<int> ST) {
-  for (int j = 0; j < 3; j++) {
-    ST[j] += t[j][v];
-    if (j != i)
-      r[j][v] += ST[j];
-  }
+  struct Entry {
+    int v, k, enter; // vertex, its next child, tour position of v
+  };
+  std::vector<Entry> stack;
+  std::vector<int> tour;
+  tour.reserve(2 * n);
 
-  for (auto &[u, id] : elist[v]) {
-    auto [d, color] = SW[id];
-    bool isDirectedToV = (dir(u, v) == d);
-    if (color == i && isDirectedToV) {
-      dfs_r(u, i, elist, SW, t, r, ST);
+  auto enter = [&](int v) {
+    stack.push_back({v, off[v], (int)tour.size()});
+    tour.push_back(v);
+    p[v] = stack.size();
+  };
+
+  enter(root);
+  while (!stack.empty()) {
+    auto &[v, k, start] = stack.back();
+    if (k < off[v + 1]) {
+      enter(children[k++]);
+      continue;
     }
+    t[v] = ((int)tour.size() - start + 1) / 2;
+    tour.push_back(~v);
+    stack.pop_back();
   }
+  return tour;
 }
 
 /**
@@ -56,56 +69,155 @@ T_1, T_2:
  *                 edge root(T_{i-1})<-->root(T_{i+1}).
  *     - w[i][v] = r[i][w] - p[i-1][w]
  * Turns out that (w[0][v], w[1][v]) is planar straight-line embedding.
+ *
+ * Values of every kind are kept in one array, row i for T_i. p and t come
+ * from an Euler tour of every tree, the three built at once. r[j][v] is the
+ * sum of t[j] over the paths from v to the roots of the other two trees, minus
+ * t[j][v]: prefix sums of t[j] over their tours, added when entering a vertex
+ * and subtracted when leaving it, in blocks on up to threads threads.
  */
-std::vector<std::pair<int, int>> find_embedding_for_schnyder_wood(
-    const std::vector<std::list<std::pair<int, int>>> &elist,
-    const std::vector<std::pair<int, int>> &SW, int a, int b, int c) {
-  int n = elist.size() - 1;
+std::vector<std::pair<int, int>>
+find_embedding_for_schnyder_wood(const HalfEdgeGraph &graph,
+                                 const std::vector<std::pair<int, int>> &SW,
+                                 int a, int b, int c, int threads) {
+  int n = graph.n;
+  size_t N = n + 1;
+  int m = graph.edges();
+  int blocks = std::max(1, std::min(threads > 0 ? threads : default_threads(),
+                                    n / 4096));
+  auto row = [&](std::vector<int> &values, int i) {
+    return values.data() + i * N;
+  };
+
+  // Parent of every vertex in T_i, 0 for the roots and vertices not in T_i.
+  std::vector<int> parent(3 * N, 0);
+  parallel_for(blocks, threads, [&](int k) {
+    for (int e = (long long)m * k / blocks; e < (long long)m * (k + 1) / blocks;
+         e++) {
+      auto [d, color] = SW[e];
+      if (color == -1)
+        continue;
+      int x = graph.head[2 * e + 1], y = graph.head[2 * e];
+      if (dir(y, x) == d)
+        row(parent, color)[y] = x;
+      else
+        row(parent, color)[x] = y;
+    }
+  });
 
-  std::vector<std::vector<int>> p(3, std::vector<int>(n + 1, 0));
-  std::vector<std::vector<int>> t(3, std::vector<int>(n + 1, 0));
+  std::vector<int> p(3 * N, 0);
+  std::vector<int> t(3 * N, 0);
 
   // Define t[i][v] for outer vertices v not in T_i.
-  t[0][b] = t[1][a] = t[2][c] = 1;
-
-  // Define p[i][v] for roots of T_i.
-  p[0][c] = p[1][b] = p[2][a] = 1;
+  row(t, 0)[b] = row(t, 1)[a] = row(t, 2)[c] = 1;
 
   // Calculate p[] and t[] values.
-  dfs_pt(c, 0, elist, SW, p, t);
-  dfs_pt(b, 1, elist, SW, p, t);
-  dfs_pt(a, 2, elist, SW, p, t);
+  int root[3] = {c, b, a};
+  std::vector<int> tour[3];
+  parallel_for(3, threads, [&](int i) {
+    tour[i] = euler_tour(root[i], row(parent, i), n, row(p, i), row(t, i));
+  });
+  parent = {};
 
-  // Calculate r[] values.
-  std::vector<std::vector<int>> r(3, std::vector<int>(n + 1, 0));
-  dfs_r(c, 0, elist, SW, t, r, {0, 0, 0});
-  dfs_r(b, 1, elist, SW, t, r, {0, 0, 0});
-  dfs_r(a, 2, elist, SW, t, r, {0, 0, 0});
+  // Only w[0] and w[1] are drawn, so only r[0] and r[1] are needed: the sums
+  // of t[0] over T_1 and T_2 and of t[1] over T_0 and T_2. The sums can
+  // exceed int, unlike r[], so they are kept modulo 2^32.
+  const int scans[4][2] = {{1, 0}, {2, 0}, {0, 1}, {2, 1}}; // {tree, j}
+  std::vector<unsigned> sums(4 * N, 0);
+  auto scan = [&](int s, int k, unsigned sum, bool write) {
+    const std::vector<int> &order = tour[scans[s][0]];
+    const int *T = row(t, scans[s][1]);
+    unsigned *out = sums.data() + s * N;
+    long long size = order.size();
+    for (int q = size * k / blocks; q < size * (k + 1) / blocks; q++) {
+      int v = order[q];
+      if (v >= 0) {
+        sum += T[v];
+        if (write)
+          out[v] = sum;
+      } else
+        sum -= T[~v];
+    }
+    return sum;
+  };
 
+  // Sums of the blocks, then of the blocks before each.
+  std::vector<unsigned> before(4 * blocks, 0);
+  if (blocks > 1) {
+    parallel_for(4 * blocks, threads, [&](int q) {
+      before[q] = scan(q / blocks, q % blocks, 0, false);
+    });
+    for (int s = 0; s < 4; s++) {
+      unsigned sum = 0;
+      for (int k = 0; k < blocks; k++) {
+        unsigned block = before[s * blocks + k];
+        before[s * blocks + k] = sum;
+        sum += block;
+      }
+    }
+  }
+  parallel_for(4 * blocks, threads, [&](int q) {
+    scan(q / blocks, q % blocks, before[q], true);
+  });
   for (int i = 0; i < 3; i++)
-    for (int v = 1; v <= n; v++)
-      r[i][v] -= t[i][v];
-
-  // Calculate w[] values.
-  std::vector<std::vector<int>> w(3, std::vector<int>(n + 1, 0));
+    tour[i] = {};
 
-  for (int i = 0; i < 3; i++)
-    for (int v = 1; v <= n; v++)
-      w[i][v] = r[i][v] - p[(i + 2) % 3][v];
+  // Calculate w[] values, in one pass over contiguous arrays.
+  std::vector<std::pair<int, int>> embedding(n + 1, {-1, -1});
+  const int *t0 = row(t, 0), *t1 = row(t, 1);
+  const int *p0 = row(p, 0), *p2 = row(p, 2);
+  const unsigned *s0 = sums.data(), *s1 = s0 + N, *s2 = s1 + N, *s3 = s2 + N;
+  parallel_for(blocks, threads, [&](int k) {
+    for (int v = 1 + (long long)n * k / blocks;
+         v < 1 + (long long)n * (k + 1) / blocks; v++)
+      embedding[v] = {(int)(s0[v] + s1[v] - t0[v] - p2[v]),
+                      (int)(s2[v] + s3[v] - t1[v] - p0[v])};
+  });
 
   // For outer vertices w[] are different.
-  w[0][c] = n - 2;
-  w[1][c] = 1;
-  w[1][b] = n - 2;
-  w[2][b] = 1;
-  w[2][a] = n - 1;
-  w[0][a] = 1;
-
-  // Build output.
-  std::vector<std::pair<int, int>> embedding(n + 1, {-1, -1});
+  embedding[c] = {n - 2, 1};
+  embedding[b].second = n - 2;
+  embedding[a].first = 1;
 
-  for (int v = 1; v <= n; v++)
-    embedding[v] = {w[0][v], w[1][v]};
+  return embedding;
+}
+
+/**
+ * Finds straight-line planar embedding of a triangulation on
+ * {0..|V|-2} x {0..|V|-2} grid, using its Schnyder wood. No two edges of the
+ * triangulation cross, so the drawing is valid for each of its subgraphs too.
+ *
+ * @complexity O(|V|)
+ * @param triangulated Triangulation with at least 3 vertices, adjacency
+ * sorted according to its combinatorial embedding.
+ * @param threads Number of threads computing the coordinates, 0 means
+ * default_threads(). The drawing does not depend on it.
+ * @return Planar embedding as vector of coordinates on the grid.
+ */
+std::vector<std::pair<int, int>> draw_triangulation(const Graph &triangulated,
+                                                    int threads) {
+  // Queues live until the drawing is done.
+  arena::Scope scope(32ll * triangulated.n);
+
+  ARA_PROFILE_LAPS(laps);
+  HalfEdgeGraph triangulation(triangulated);
+  ARA_PROFILE_LAP(laps, "half_edges");
+
+  // The first face is the outer one.
+  int h = triangulation.first[1];
+  int a = 1;
+  int b = triangulation.head[h];
+  int c = triangulation.head[triangulation.face_next(h)];
+  assert(triangulation.head[triangulation.face_next(
+             triangulation.face_next(h))] == a);
+
+  std::vector<std::pair<int, int>> SW =
+      get_schnyder_wood(triangulation, a, b, c);
+  ARA_PROFILE_LAP(laps, "schnyder_wood");
+
+  std::vector<std::pair<int, int>> embedding =
+      find_embedding_for_schnyder_wood(triangulation, SW, a, b, c, threads);
+  ARA_PROFILE_LAP(laps, "coordinates");
 
   return embedding;
 }
@@ -113,39 +225,167 @@ std::vector<std::pair<int, int>> find_embedding_for_schnyder_wood(
 /**
  * Finds straight-line planar embedding of a simple graph on
  * {0..|V|-2} x {0..|V|-2} grid. Assumes the graph does not
- * contain loops or multiedges. The graphs does not have to be connected.
+ * contain loops. Repeated edges are merged in graph first, see
+ * merge_parallel_edges. The graph does not have to be connected.
+ * Planarity is tested on the kernel of the graph, see is_planar_reduced.
+ * Forests and disjoint cycles are drawn directly, see draw_trees_and_cycles.
  *
- * Throws exception if the graphs is not planar.
+ * Throws exception if the graphs is not planar or has less than 3 vertices.
  *
  * @complexity O(|V| + |E|)
- * @param list Adjacency list of the graph.
+ * @param graph The graph.
+ * @param threads Number of threads testing planarity, triangulating and
+ * drawing. Other than 1 tests biconnected components separately, see
+ * is_planar_by_blocks, which may give another rotation system and drawing
+ * than 1. The drawing of a given rotation system does not depend on it.
+ * @param workspace Buffers of is_planar reused across calls, or nullptr.
  * @return Planar embedding as vector of coordinates on the grid.
  */
 std::vector<std::pair<int, int>>
-planar_embedding(std::vector<std::list<int>> &list) {
-  list = is_planar(list);
+planar_embedding(Graph &graph, int threads, PlanarityWorkspace *workspace) {
+  if (graph.n < 3)
+    throw std::invalid_argument("The graph has less than 3 vertices.");
+  merge_parallel_edges(graph);
+
+  ARA_PROFILE_LAPS(laps);
+  std::vector<std::pair<int, int>> coords = draw_trees_and_cycles(graph);
+  ARA_PROFILE_LAP(laps, "trees_and_cycles");
+  if (!coords.empty())
+    return coords;
 
-  if (list.empty())
+  graph = is_planar_reduced(graph, threads, workspace);
+  ARA_PROFILE_RESET(laps); // is_planar_reduced records its own stages
+
+  if (graph.empty())
     throw std::invalid_argument("The graph is not planar.");
 
-  std::vector<std::list<int>> triangulation_list = get_triangulation(list);
+  Graph triangulated = get_triangulation(graph, threads);
+  ARA_PROFILE_LAP(laps, "get_triangulation");
 
-  std::vector<std::list<std::pair<int, int>>> triangulation_elist =
-      enumerate_adjacency_list(triangulation_list);
+  return draw_triangulation(triangulated, threads);
+}
 
-  std::vector<EdgeCrossRef> CR = getEdgeCrossReferences(triangulation_elist);
+/**
+ * Packs boxes into a strip with the shelf algorithm: boxes sorted by
+ * decreasing height are placed left to right on shelves as wide as the
+ * widest box or the side of a square of the total area, whichever is larger.
+ *
+ * @complexity O(k log k)
+ * @param sizes Width and height of k boxes.
+ * @return Position of the lower left corner of every box.
+ */
+std::vector<std::pair<int, int>>
+shelf_pack(const std::vector<std::pair<int, int>> &sizes) {
+  int k = sizes.size();
+  std::vector<int> order(k);
+  long long area = 0;
+  int width = 0;
+  for (int i = 0; i < k; i++) {
+    order[i] = i;
+    area += (long long)sizes[i].first * sizes[i].second;
+    width = std::max(width, sizes[i].first);
+  }
+  width = std::max(width, (int)std::ceil(std::sqrt((double)area)));
+  std::stable_sort(order.begin(), order.end(), [&](int i, int j) {
+    return sizes[i].second > sizes[j].second;
+  });
 
-  std::vector<std::vector<std::pair<int, int>>> faces =
-      find_faces(triangulation_elist, CR);
+  std::vector<std::pair<int, int>> position(k);
+  int x = 0, y = 0, shelf_height = 0;
+  for (int i : order) {
+    auto [w, h] = sizes[i];
+    if (x + w > width) {
+      x = 0;
+      y += shelf_height;
+      shelf_height = 0;
+    }
+    position[i] = {x, y};
+    x += w;
+    shelf_height = std::max(shelf_height, h);
+  }
+  return position;
+}
 
-  assert(!faces.empty() && faces[0].size() == 3);
+/**
+ * Finds straight-line planar embedding of every connected component of a
+ * simple graph separately, on up to threads threads, and packs the drawings
+ * side by side with a shelf packer. Unlike planar_embedding, the size of the
+ * grid depends on the sizes of the components: a forest of small trees gets a
+ * grid of side O(sqrt(|V|)) instead of |V| - 2. Components with less than 3
+ * vertices are drawn as a point or a segment.
+ *
+ * Throws exception if the graph is not planar.
+ *
+ * @complexity O(|V| + |E|) work, plus O(c log c) for c components
+ * @param graph The graph.
+ * @param threads Number of threads, 0 means default_threads().
+ * @return Planar embedding as vector of coordinates on the grid.
+ */
+std::vector<std::pair<int, int>>
+planar_embedding_by_components(const Graph &graph, int threads) {
+  int n = graph.n;
+  std::vector<int> component;
+  int k = label_components(graph, component, threads);
+
+  // Split the graph into components with vertices renumbered from 1.
+  std::vector<int> local(n + 1), size(k, 0);
+  for (int v = 1; v <= n; v++)
+    local[v] = ++size[component[v]];
+  std::vector<std::vector<std::pair<int, int>>> edges(k);
+  for (int v = 1; v <= n; v++)
+    for (auto u : graph.neighbours(v))
+      if (v < u)
+        edges[component[v]].push_back({local[v], local[u]});
 
-  int a = faces[0][0].first;
-  int b = faces[0][1].first;
-  int c = faces[0][2].first;
+  // Largest components first, so that no thread is left with a big one at the
+  // end.
+  std::vector<int> order(k);
+  for (int c = 0; c < k; c++)
+    order[c] = c;
+  std::stable_sort(order.begin(), order.end(),
+                   [&](int a, int b) { return size[a] > size[b]; });
 
-  std::vector<std::pair<int, int>> SW =
-      get_schnyder_wood(triangulation_elist, a, b, c);
+  std::vector<std::vector<std::pair<int, int>>> drawing(k);
+  parallel_for(k, threads, [&](int i) {
+    int c = order[i];
+    if (size[c] == 1)
+      drawing[c] = {{-1, -1}, {0, 0}};
+    else if (size[c] == 2)
+      drawing[c] = {{-1, -1}, {0, 0}, {1, 0}};
+    else {
+      Graph part = build_graph(size[c], edges[c]);
+      edges[c].clear();
+      edges[c].shrink_to_fit();
+      drawing[c] = planar_embedding(part);
+    }
+  });
 
-  return find_embedding_for_schnyder_wood(triangulation_elist, SW, a, b, c);
+  // Bounding boxes, drawings are moved to start at (0, 0).
+  std::vector<std::pair<int, int>> box(k);
+  for (int c = 0; c < k; c++) {
+    int min_x = drawing[c][1].first, min_y = drawing[c][1].second;
+    int max_x = min_x, max_y = min_y;
+    for (size_t v = 2; v < drawing[c].size(); v++) {
+      auto [x, y] = drawing[c][v];
+      min_x = std::min(min_x, x);
+      min_y = std::min(min_y, y);
+      max_x = std::max(max_x, x);
+      max_y = std::max(max_y, y);
+    }
+    for (size_t v = 1; v < drawing[c].size(); v++) {
+      drawing[c][v].first -= min_x;
+      drawing[c][v].second -= min_y;
+    }
+    box[c] = {max_x - min_x + 1, max_y - min_y + 1};
+  }
+
+  std::vector<std::pair<int, int>> position = shelf_pack(box);
+
+  std::vector<std::pair<int, int>> embedding(n + 1, {-1, -1});
+  for (int v = 1; v <= n; v++) {
+    auto [x, y] = drawing[component[v]][local[v]];
+    auto [px, py] = position[component[v]];
+    embedding[v] = {px + x, py + y};
+  }
+  return embedding;
 }
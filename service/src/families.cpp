@@ -0,0 +1,90 @@
+#include "families.hpp"
+#include "graph.hpp"
+#include <algorithm>
+#include <vector>
+
+/**
+ * Draws a graph whose every connected component is a tree or a cycle
+ * (forests, paths, cycles) directly, without the planarity test,
+ * triangulation and Schnyder wood. Components get consecutive columns: a tree
+ * is drawn with x from its DFS preorder and y its depth, rooted at a vertex
+ * of degree at least 2 if there is one, and a cycle as a path on a row closed
+ * by one vertex above its start. Graphs with more than |V| edges are rejected
+ * without a scan.
+ *
+ * @complexity O(|V| + |E|)
+ * @param graph The graph, with at least one edge and 3 vertices.
+ * @return Straight-line embedding as vector of coordinates on
+ * {0..|V|-2} x {0..|V|-2} grid, or empty vector if some component is neither
+ * a tree nor a cycle.
+ */
+std::vector<std::pair<int, int>> draw_trees_and_cycles(const Graph &graph) {
+  int n = graph.n;
+  long long m = graph.edges();
+  if (m == 0 || m > n)
+    return {};
+
+  std::vector<std::pair<int, int>> coords(n + 1, {-1, -1});
+  std::vector<int> depth(n + 1, -1); // -1 until visited
+  std::vector<int> order;            // component in DFS preorder
+  std::vector<std::pair<int, int>> stack; // {vertex, current half-edge}
+  order.reserve(n);
+  stack.reserve(n);
+  int column = 0;
+
+  // Draws the component of root in columns from column on. Iterative, so its
+  // depth is not limited by the call stack.
+  auto draw = [&](int root) {
+    order.assign(1, root);
+    depth[root] = 0;
+    stack.push_back({root, graph.off[root]});
+    while (!stack.empty()) {
+      auto &[v, i] = stack.back();
+      if (i == graph.off[v + 1]) {
+        stack.pop_back();
+        continue;
+      }
+      int u = graph.adj[i++];
+      if (depth[u] == -1) {
+        depth[u] = depth[v] + 1;
+        order.push_back(u);
+        stack.push_back({u, graph.off[u]});
+      }
+    }
+
+    long long degrees = 0;
+    bool cycle = true;
+    for (int v : order) {
+      degrees += graph.degree(v);
+      cycle = cycle && graph.degree(v) == 2;
+    }
+    int s = order.size();
+
+    if (degrees / 2 == s - 1) {
+      // Preorder puts every subtree in its own range of columns, and only
+      // edges from depth d to d + 1 lie between these rows, ordered like their
+      // ends. The first child goes right below the root, to save a column.
+      for (int j = 0; j < s; j++)
+        coords[order[j]] = {column + std::max(j - 1, 0), depth[order[j]]};
+      column += std::max(s - 1, 1);
+      return true;
+    }
+    if (cycle) {
+      for (int j = 0; j < s - 1; j++)
+        coords[order[j]] = {column + j, 0};
+      coords[order[s - 1]] = {column, 1};
+      column += s - 1;
+      return true;
+    }
+    return false;
+  };
+
+  // Roots of degree at least 2 keep the depth of trees below |V| - 1.
+  for (int min_degree : {2, 1, 0})
+    for (int v = 1; v <= n; v++)
+      if (depth[v] == -1 && std::min(graph.degree(v), 2) == min_degree &&
+          !draw(v))
+        return {};
+
+  return coords;
+}
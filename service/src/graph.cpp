@@ -0,0 +1,276 @@
+#include "graph.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <span>
+#include <vector>
+
+/**
+ * Build graph from an edge list. Neighbours of every vertex are kept in the
+ * order in which the edges appear.
+ *
+ * @complexity O(|V| + |E|)
+ * @param n Number of vertices.
+ * @param edges Undirected edges {u, v} with u, v in [1, n].
+ * @return Graph with both half-edges of every edge.
+ */
+Graph build_graph(int n, const std::vector<std::pair<int, int>> &edges) {
+  Graph g(n);
+  for (auto &[u, v] : edges) {
+    g.off[u + 1]++;
+    g.off[v + 1]++;
+  }
+  for (int v = 1; v <= n; v++)
+    g.off[v + 1] += g.off[v];
+
+  g.adj.resize(2 * edges.size());
+  std::vector<int> pos(g.off.begin(), g.off.end() - 1);
+  for (auto &[u, v] : edges) {
+    g.adj[pos[u]++] = v;
+    g.adj[pos[v]++] = u;
+  }
+
+  return g;
+}
+
+/**
+ * Build graph from a flat edge list, edge i being
+ * {endpoints[2i], endpoints[2i + 1]}. Neighbours of every vertex are kept in
+ * the order in which the edges appear.
+ *
+ * @complexity O(|V| + |E|)
+ * @param n Number of vertices.
+ * @param endpoints 2|E| endpoints from [1, n].
+ * @return Graph with both half-edges of every edge.
+ */
+Graph build_graph_flat(int n, std::span<const int> endpoints) {
+  Graph g(n);
+  for (auto v : endpoints)
+    g.off[v + 1]++;
+  for (int v = 1; v <= n; v++)
+    g.off[v + 1] += g.off[v];
+
+  g.adj.resize(endpoints.size());
+  std::vector<int> pos(g.off.begin(), g.off.end() - 1);
+  for (size_t i = 0; i < endpoints.size(); i += 2) {
+    int u = endpoints[i], v = endpoints[i + 1];
+    g.adj[pos[u]++] = v;
+    g.adj[pos[v]++] = u;
+  }
+
+  return g;
+}
+
+/**
+ * Build graph from a list of directed arcs. Only arc u->v is stored, in
+ * the adjacency of u, in the order in which the arcs appear.
+ *
+ * @complexity O(|V| + |E|)
+ * @param n Number of vertices.
+ * @param arcs Arcs {u, v} with u, v in [1, n].
+ * @return Directed graph.
+ */
+Graph build_digraph(int n, const std::vector<std::pair<int, int>> &arcs) {
+  Graph g(n);
+  for (auto &[u, v] : arcs)
+    g.off[u + 1]++;
+  for (int v = 1; v <= n; v++)
+    g.off[v + 1] += g.off[v];
+
+  g.adj.resize(arcs.size());
+  std::vector<int> pos(g.off.begin(), g.off.end() - 1);
+  for (auto &[u, v] : arcs)
+    g.adj[pos[u]++] = v;
+
+  return g;
+}
+
+/**
+ * Append undirected edges to the graph. New neighbours are placed at the end
+ * of adjacency of both endpoints, in the order in which the edges appear.
+ * Drops edge ids.
+ *
+ * @complexity O(|V| + |E|)
+ * @param graph The graph.
+ * @param edges Edges to add.
+ */
+void append_edges(Graph &graph, const std::vector<std::pair<int, int>> &edges) {
+  int n = graph.n;
+  Graph _graph(n);
+  for (int v = 1; v <= n; v++)
+    _graph.off[v + 1] = graph.degree(v);
+  for (auto &[u, v] : edges) {
+    _graph.off[u + 1]++;
+    _graph.off[v + 1]++;
+  }
+  for (int v = 1; v <= n; v++)
+    _graph.off[v + 1] += _graph.off[v];
+
+  _graph.adj.resize(graph.adj.size() + 2 * edges.size());
+  std::vector<int> pos(_graph.off.begin(), _graph.off.end() - 1);
+  for (int v = 1; v <= n; v++)
+    for (auto u : graph.neighbours(v))
+      _graph.adj[pos[v]++] = u;
+  for (auto &[u, v] : edges) {
+    _graph.adj[pos[u]++] = v;
+    _graph.adj[pos[v]++] = u;
+  }
+
+  graph = std::move(_graph);
+}
+
+/**
+ * Checks whether some edge of the graph is repeated, i.e. some vertex has the
+ * same neighbour twice.
+ *
+ * @complexity O(|V| + |E|)
+ * @param graph The graph.
+ * @return Whether the graph has multiedges.
+ */
+bool has_parallel_edges(const Graph &graph) {
+  // mark[u] == v iff u was already seen in adjacency of v.
+  std::vector<int> mark(graph.n + 1, 0);
+  for (int v = 1; v <= graph.n; v++)
+    for (auto u : graph.neighbours(v)) {
+      if (mark[u] == v)
+        return true;
+      mark[u] = v;
+    }
+  return false;
+}
+
+/**
+ * Merges repeated edges into one, keeping the first occurrence of every
+ * neighbour in adjacency of every vertex. Drops edge ids if an edge is
+ * removed.
+ *
+ * @complexity O(|V| + |E|)
+ * @param graph The graph.
+ * @return Number of removed edges.
+ */
+int merge_parallel_edges(Graph &graph) {
+  if (graph.empty())
+    return 0;
+  int n = graph.n;
+  std::vector<int> mark(n + 1, 0);
+
+  // Adjacency is compacted in place, as kept half-edges only move back.
+  int kept = 0, begin = graph.off[1];
+  for (int v = 1; v <= n; v++) {
+    int end = graph.off[v + 1];
+    graph.off[v] = kept;
+    for (int i = begin; i < end; i++) {
+      int u = graph.adj[i];
+      if (mark[u] == v)
+        continue;
+      mark[u] = v;
+      graph.adj[kept++] = u;
+    }
+    begin = end;
+  }
+  graph.off[n + 1] = kept;
+
+  int removed = (graph.adj.size() - kept) / 2;
+  graph.adj.resize(kept);
+  if (removed > 0)
+    graph.eid.clear();
+  return removed;
+}
+
+/**
+ * Labels connected components with concurrent union-find over the edges, on
+ * up to threads threads. Every edge links the root with the larger id under
+ * the one with the smaller, so the root of a component ends up being its
+ * smallest vertex and components are numbered in the order of their smallest
+ * vertices, whatever the number of threads. On one thread, or on a small
+ * graph, components are labelled with BFS instead.
+ *
+ * @complexity O((|V| + |E|) log |V|) work
+ * @param graph The graph.
+ * @param component Receives component of every vertex, from [0, count).
+ * @param threads Number of threads, 0 means default_threads().
+ * @return Number of components.
+ */
+int label_components(const Graph &graph, std::vector<int> &component,
+                     int threads) {
+  int n = graph.n;
+  int blocks = std::max(1, std::min(threads > 0 ? threads : default_threads(),
+                                    n / 4096));
+  auto begin = [&](int b) { return 1 + (int)((long long)n * b / blocks); };
+
+  // A single thread is faster with BFS, which numbers components the same.
+  if (blocks == 1) {
+    component.assign(n + 1, -1);
+    std::vector<int> queue;
+    queue.reserve(n);
+    int count = 0;
+    for (int s = 1; s <= n; s++) {
+      if (component[s] != -1)
+        continue;
+      component[s] = count;
+      queue.assign(1, s);
+      for (size_t i = 0; i < queue.size(); i++)
+        for (auto u : graph.neighbours(queue[i]))
+          if (component[u] == -1) {
+            component[u] = count;
+            queue.push_back(u);
+          }
+      count++;
+    }
+    return count;
+  }
+
+  // Parents only ever decrease, so every value read is an ancestor, even if a
+  // stale one, and relaxed order is enough.
+  std::vector<std::atomic<int>> parent(n + 1);
+  parallel_for(blocks, threads, [&](int b) {
+    for (int v = begin(b); v < begin(b + 1); v++)
+      parent[v].store(v, std::memory_order_relaxed);
+  });
+
+  // Root of v, halving the path on the way.
+  auto find = [&](int v) {
+    int p = parent[v].load(std::memory_order_relaxed);
+    while (p != v) {
+      int g = parent[p].load(std::memory_order_relaxed);
+      if (g != p)
+        parent[v].compare_exchange_weak(p, g, std::memory_order_relaxed);
+      v = p;
+      p = g;
+    }
+    return v;
+  };
+
+  parallel_for(blocks, threads, [&](int b) {
+    for (int v = begin(b); v < begin(b + 1); v++)
+      for (auto u : graph.neighbours(v)) {
+        if (u < v)
+          continue;
+        int x = find(v), y = find(u);
+        // Retry if the larger root got linked meanwhile.
+        while (x != y) {
+          if (x > y)
+            std::swap(x, y);
+          int root = y;
+          if (parent[y].compare_exchange_strong(root, x,
+                                                std::memory_order_relaxed))
+            break;
+          x = find(x);
+          y = find(root);
+        }
+      }
+  });
+
+  component.assign(n + 1, -1);
+  parallel_for(blocks, threads, [&](int b) {
+    for (int v = begin(b); v < begin(b + 1); v++)
+      component[v] = find(v);
+  });
+
+  // Roots are smaller than the rest of their components, so they get their
+  // labels first.
+  int count = 0;
+  for (int v = 1; v <= n; v++)
+    component[v] = (component[v] == v) ? count++ : component[component[v]];
+  return count;
+}
@@ -0,0 +1,139 @@
+#include "half_edge.hpp"
+#include "graph.hpp"
+#include "utils.hpp"
+#include <vector>
+
+/**
+ * Vertices with no half-edges linked yet, and edges unlinked half-edges
+ * whose heads are to be set by the caller.
+ *
+ * @complexity O(|V| + |E|)
+ * @param n Number of vertices.
+ * @param edges Number of edges.
+ */
+HalfEdgeGraph::HalfEdgeGraph(int _n, int edges)
+    : n(_n), head(2 * edges, 0), next(2 * edges, -1), prev(2 * edges, -1),
+      first(_n + 1, -1), degree(_n + 1, 0) {}
+
+/**
+ * Same as HalfEdgeGraph(n, edges), reusing the buffers: allocates nothing
+ * unless they are too small.
+ *
+ * @complexity O(|V| + |E|)
+ * @param n Number of vertices.
+ * @param edges Number of edges.
+ */
+void HalfEdgeGraph::assign(int _n, int edges) {
+  n = _n;
+  head.assign(2 * edges, 0);
+  next.assign(2 * edges, -1);
+  prev.assign(2 * edges, -1);
+  first.assign(n + 1, -1);
+  degree.assign(n + 1, 0);
+}
+
+/**
+ * Half-edges of a combinatorial embedding. Edge e is the (e + 1)-th edge of
+ * enumerate_adjacency_list and half-edge 2e goes from its smaller endpoint.
+ *
+ * @complexity O(|V| + |E|)
+ * @param graph Graph with adjacency sorted according to the embedding.
+ */
+HalfEdgeGraph::HalfEdgeGraph(const Graph &graph)
+    : HalfEdgeGraph(graph.n, graph.edges()) {
+  Graph egraph = enumerate_adjacency_list(graph);
+  for (int v = 1; v <= n; v++) {
+    int last = -1;
+    for (int i = egraph.off[v]; i < egraph.off[v + 1]; i++) {
+      int u = egraph.adj[i];
+      int h = 2 * (egraph.eid[i] - 1) + (v > u);
+      head[h] = u;
+      if (last == -1) {
+        first[v] = h;
+      } else {
+        next[last] = h;
+        prev[h] = last;
+      }
+      last = h;
+    }
+    if (last != -1) {
+      next[last] = first[v];
+      prev[first[v]] = last;
+    }
+    degree[v] = egraph.degree(v);
+  }
+}
+
+// Makes room for edges edges, so that adding them moves nothing.
+void HalfEdgeGraph::reserve(int edges) {
+  head.reserve(2 * edges);
+  next.reserve(2 * edges);
+  prev.reserve(2 * edges);
+}
+
+// Adds edge {u, v} with unlinked half-edges u->v and v->u. Returns its id.
+int HalfEdgeGraph::add_edge(int u, int v) {
+  head.push_back(v);
+  head.push_back(u);
+  next.resize(head.size(), -1);
+  prev.resize(head.size(), -1);
+  return edges() - 1;
+}
+
+// Links unlinked half-edge h into rotation of its tail after half-edge g,
+// or as the only one if g is -1.
+void HalfEdgeGraph::insert_after(int g, int h) {
+  int x = tail(h);
+  if (g == -1) {
+    next[h] = prev[h] = first[x] = h;
+  } else {
+    next[h] = next[g];
+    prev[h] = g;
+    prev[next[g]] = h;
+    next[g] = h;
+  }
+  degree[x]++;
+}
+
+// Links unlinked half-edge h into rotation of its tail before half-edge g,
+// or as the only one if g is -1.
+void HalfEdgeGraph::insert_before(int g, int h) {
+  int x = tail(h);
+  if (g == -1) {
+    next[h] = prev[h] = first[x] = h;
+    degree[x]++;
+    return;
+  }
+  insert_after(prev[g], h);
+  if (first[x] == g)
+    first[x] = h;
+}
+
+/**
+ * Graph with adjacency in rotation order, each read from first.
+ *
+ * @complexity O(|V| + |E|)
+ * @param enumerated Whether to fill eid, edge e getting id e + 1.
+ * @return The graph.
+ */
+Graph HalfEdgeGraph::to_graph(bool enumerated) const {
+  Graph graph(n);
+  for (int v = 1; v <= n; v++)
+    graph.off[v + 1] = graph.off[v] + degree[v];
+
+  graph.adj.reserve(head.size());
+  if (enumerated)
+    graph.eid.reserve(head.size());
+  for (int v = 1; v <= n; v++) {
+    if (first[v] == -1)
+      continue;
+    int h = first[v];
+    do {
+      graph.adj.push_back(head[h]);
+      if (enumerated)
+        graph.eid.push_back(h / 2 + 1);
+      h = next[h];
+    } while (h != first[v]);
+  }
+  return graph;
+}
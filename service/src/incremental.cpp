@@ -0,0 +1,261 @@
+#include "incremental.hpp"
+#include "embedding.hpp"
+#include "graph.hpp"
+#include "half_edge.hpp"
+#include "planar.hpp"
+#include "triangulation.hpp"
+#include "utils.hpp"
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * Throws exception if the graph is not planar or has less than 3 vertices.
+ *
+ * @complexity O(|V| + |E|)
+ * @param graph The graph, without loops or multiedges.
+ */
+IncrementalEmbedding::IncrementalEmbedding(const Graph &graph)
+    : n(graph.n), drawn(false) {
+  if (n < 3)
+    throw std::invalid_argument("The graph has less than 3 vertices.");
+
+  Graph planar = is_planar(graph);
+  if (planar.empty())
+    throw std::invalid_argument("The graph is not planar.");
+
+  build(planar);
+}
+
+/* Replaces the stored embedding by the given one and traces its faces. */
+void IncrementalEmbedding::build(const Graph &embedding) {
+  rotation = HalfEdgeGraph(embedding);
+  int m = rotation.edges();
+
+  face.assign(2 * m, -1);
+  component.resize(n + 1);
+  std::iota(component.begin(), component.end(), 0);
+  for (int h = 0; h < 2 * m; h += 2)
+    component[find(rotation.tail(h))] = find(rotation.head[h]);
+
+  // Same tracing as in find_faces: after h = x->y comes the half-edge before
+  // y->x in rotation of y.
+  face_size.clear();
+  for (int h = 0; h < 2 * m; h++)
+    if (face[h] == -1)
+      face_size.push_back(label(h, rotation.next[h] ^ 1, face_size.size()));
+
+  corner.assign(face_size.size(), -1);
+  neighbour.assign(n + 1, -1);
+  drawn = false;
+}
+
+/* Root of v in the union-find forest, with path halving. */
+int IncrementalEmbedding::find(int v) {
+  while (component[v] != v) {
+    component[v] = component[component[v]];
+    v = component[v];
+  }
+  return v;
+}
+
+/* Checks whether {u, v} is an edge, in O(min(deg(u), deg(v))). */
+bool IncrementalEmbedding::adjacent(int u, int v) {
+  const std::vector<int> &degree = rotation.degree;
+  if (degree[u] > degree[v])
+    std::swap(u, v);
+  int h = rotation.first[u];
+  if (h == -1)
+    return false;
+  do {
+    if (rotation.head[h] == v)
+      return true;
+    h = rotation.next[h];
+  } while (h != rotation.first[u]);
+  return false;
+}
+
+/* Half-edge out of u after which v comes in the triangulation, skipping edges
+ * which are not in the graph. Returns -1 if u has no edges, -2 if {u, v} is not
+ * an edge of the triangulation. */
+int IncrementalEmbedding::triangulation_corner(int u, int v) {
+  std::span<const int> around = triangulation.neighbours(u);
+  int k = around.size(), j = 0;
+  while (j < k && around[j] != v)
+    j++;
+  if (j == k)
+    return -2;
+  int first = rotation.first[u];
+  if (first == -1)
+    return -1;
+
+  int h = first;
+  do {
+    neighbour[rotation.head[h]] = h;
+    h = rotation.next[h];
+  } while (h != first);
+
+  // The triangulation contains every edge of the graph, so this stops.
+  int g = -1;
+  for (int i = 1; g == -1; i++)
+    g = neighbour[around[(j - i + k) % k]];
+
+  do {
+    neighbour[rotation.head[h]] = -1;
+    h = rotation.next[h];
+  } while (h != first);
+
+  return g;
+}
+
+/* Sets face of half-edges from start to stop, following the faces, to f.
+ * Returns their number. */
+int IncrementalEmbedding::label(int start, int stop, int f) {
+  int count = 1;
+  for (int h = start; h != stop; h = rotation.face_next(h), count++)
+    face[h] = f;
+  face[stop] = f;
+  return count;
+}
+
+/* Adds edge {u, v} after half-edge gu in rotation of u and after gv in
+ * rotation of v (-1 for a vertex with no edges). If gu and gv are on the same
+ * face, it is split in two and the part of v->u gets a new id. Otherwise
+ * faces of gu and gv are merged and the smaller one is relabelled. */
+void IncrementalEmbedding::splice(int u, int gu, int v, int gv) {
+  int fu = (gu == -1) ? -1 : face[gu];
+  int fv = (gv == -1) ? -1 : face[gv];
+
+  int a = 2 * rotation.add_edge(u, v), b = a + 1;
+  rotation.insert_after(gu, a);
+  rotation.insert_after(gv, b);
+  face.resize(b + 1);
+  component[find(u)] = find(v);
+
+  if (fu != -1 && fu == fv) {
+    int f = face_size.size();
+    face[a] = fu;
+    face_size.push_back(label(b, rotation.next[b] ^ 1, f));
+    face_size[fu] += 2 - face_size[f];
+    corner.push_back(-1);
+    return;
+  }
+
+  // The new face goes a, half-edges of fv, b, half-edges of fu.
+  int su = (fu == -1) ? 0 : face_size[fu];
+  int sv = (fv == -1) ? 0 : face_size[fv];
+  int f = (su >= sv) ? fu : fv;
+  if (f == -1) {
+    f = face_size.size();
+    face_size.push_back(0);
+    corner.push_back(-1);
+  }
+  if (f == fu)
+    label(a, b, f);
+  else
+    label(b, a, f);
+  face_size[f] = su + sv + 2;
+}
+
+/**
+ * Inserts edge {u, v} if the graph stays planar. Throws exception if the
+ * edge is a loop, already exists or has an endpoint outside of [1, |V|].
+ *
+ * @complexity O(deg(u) + deg(v)) for an edge of the triangulation or
+ * between components, plus size of the split face if u and v share a face,
+ * O(|V| + |E|) otherwise.
+ * @param u First endpoint.
+ * @param v Second endpoint.
+ * @return How the edge was inserted, or NotPlanar.
+ */
+IncrementalEmbedding::Insertion IncrementalEmbedding::insert_edge(int u,
+                                                                  int v) {
+  if (u < 1 || u > n || v < 1 || v > n || u == v)
+    throw std::invalid_argument("Edge endpoint outside of [1, n] or loop.");
+  if (adjacent(u, v))
+    throw std::invalid_argument("The edge already exists.");
+
+  if (exceeds_euler_bound(n, edges() + 1))
+    return Insertion::NotPlanar;
+
+  // The edge is already drawn. Corners are taken from the triangulation, so
+  // that it stays an extension of the embedding.
+  if (drawn) {
+    int gu = triangulation_corner(u, v);
+    if (gu != -2) {
+      splice(u, gu, v, triangulation_corner(v, u));
+      return Insertion::Drawn;
+    }
+  }
+
+  // Any face of a component can be drawn inside any face of another one.
+  if (find(u) != find(v)) {
+    splice(u, rotation.first[u], v, rotation.first[v]);
+    drawn = false;
+    return Insertion::Patched;
+  }
+
+  // Find a common face of u and v.
+  const std::vector<int> &first = rotation.first, &next = rotation.next;
+  int gu = -1, gv = -1;
+  int h = first[u];
+  do {
+    corner[face[h]] = h;
+    h = next[h];
+  } while (h != first[u]);
+  h = first[v];
+  do {
+    if (corner[face[h]] != -1) {
+      gu = corner[face[h]];
+      gv = h;
+      break;
+    }
+    h = next[h];
+  } while (h != first[v]);
+  h = first[u];
+  do {
+    corner[face[h]] = -1;
+    h = next[h];
+  } while (h != first[u]);
+
+  if (gv != -1) {
+    splice(u, gu, v, gv);
+    drawn = false;
+    return Insertion::Patched;
+  }
+
+  // The edge crosses the embedding, which has to be found again.
+  Graph graph = embedding();
+  append_edges(graph, {{u, v}});
+  Graph planar = is_planar(graph);
+  if (planar.empty())
+    return Insertion::NotPlanar;
+
+  build(planar);
+  return Insertion::Reembedded;
+}
+
+/**
+ * Current combinatorial embedding.
+ *
+ * @complexity O(|V| + |E|)
+ * @return Graph with adjacency sorted according to the embedding.
+ */
+Graph IncrementalEmbedding::embedding() const { return rotation.to_graph(); }
+
+/**
+ * Straight-line drawing of the current graph, recomputed if an insertion
+ * invalidated it.
+ *
+ * @complexity O(1) if drawn, O(|V| + |E|) otherwise
+ * @return Coordinates of vertices on {0..|V|-2} x {0..|V|-2} grid, indexed
+ * from 1.
+ */
+const std::vector<std::pair<int, int>> &IncrementalEmbedding::coordinates() {
+  if (!drawn) {
+    triangulation = get_triangulation(embedding());
+    drawing = draw_triangulation(triangulation);
+    drawn = true;
+  }
+  return drawing;
+}
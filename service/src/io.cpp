@@ -0,0 +1,380 @@
+#include "io.hpp"
+#include "graph.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// Read-only memory mapping of a whole file.
+class MappedFile {
+public:
+  const char *data = nullptr;
+  size_t size = 0;
+
+  MappedFile(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+      throw std::runtime_error("Failed to open input file.");
+
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+      close(fd);
+      throw std::runtime_error("Failed to open input file.");
+    }
+    size = st.st_size;
+
+    if (size > 0) {
+      void *p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error("Failed to map input file.");
+      }
+      madvise(p, size, MADV_SEQUENTIAL);
+      data = (const char *)p;
+    }
+    close(fd);
+  }
+
+  ~MappedFile() {
+    if (data)
+      munmap((void *)data, size);
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+};
+
+inline bool is_space(char c) {
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' ||
+         c == '\f';
+}
+
+/**
+ * Parses non-negative integer starting at p (after skipping whitespace).
+ * Returns pointer after it, or nullptr if there is no valid integer.
+ */
+const char *parse_int(const char *p, const char *end, int &x) {
+  while (p < end && is_space(*p))
+    p++;
+  auto [q, ec] = std::from_chars(p, end, x);
+  if (ec != std::errc() || q == p || x < 0 || (q < end && !is_space(*q)))
+    return nullptr;
+  return q;
+}
+
+/**
+ * Parses all integers in [p, end) into out. Returns false if the range
+ * contains anything else than non-negative integers and whitespace.
+ */
+bool parse_chunk(const char *p, const char *end, std::vector<int> &out) {
+  while (true) {
+    while (p < end && is_space(*p))
+      p++;
+    if (p == end)
+      return true;
+    int x;
+    p = parse_int(p, end, x);
+    if (!p)
+      return false;
+    out.push_back(x);
+  }
+}
+
+} // namespace
+
+Graph read_graph(const char *path, int threads) {
+  MappedFile file(path);
+  const char *begin = file.data;
+  const char *end = file.data + file.size;
+
+  int n, m;
+  const char *p = begin ? parse_int(begin, end, n) : nullptr;
+  p = p ? parse_int(p, end, m) : nullptr;
+  if (!p)
+    throw std::runtime_error("Malformed input: expected header \"n m\".");
+
+  // Split the rest of the file into chunks ending at whitespace.
+  if (threads <= 0)
+    threads = default_threads();
+  const size_t min_chunk = 1 << 20;
+  int chunks = std::max<size_t>(
+      1, std::min<size_t>(4 * threads, (end - p) / min_chunk));
+  std::vector<const char *> bounds(chunks + 1);
+  bounds[0] = p;
+  bounds[chunks] = end;
+  for (int i = 1; i < chunks; i++) {
+    const char *q = p + (end - p) * i / chunks;
+    q = std::max(q, bounds[i - 1]);
+    while (q < end && !is_space(*q))
+      q++;
+    bounds[i] = q;
+  }
+
+  std::vector<std::vector<int>> tokens(chunks);
+  std::vector<char> parsed(chunks), in_range(chunks, true);
+  parallel_for(chunks, threads, [&](int i) {
+    tokens[i].reserve((bounds[i + 1] - bounds[i]) / 4);
+    parsed[i] = parse_chunk(bounds[i], bounds[i + 1], tokens[i]);
+    for (int x : tokens[i])
+      in_range[i] &= (x >= 1 && x <= n);
+  });
+
+  size_t count = 0;
+  for (int i = 0; i < chunks; i++) {
+    if (!parsed[i])
+      throw std::runtime_error("Malformed input: expected non-negative "
+                               "integers.");
+    if (!in_range[i])
+      throw std::runtime_error("Malformed input: edge endpoint outside of "
+                               "[1, n].");
+    count += tokens[i].size();
+  }
+  if (count != 2 * (size_t)m)
+    throw std::runtime_error("Malformed input: expected exactly " +
+                             std::to_string(m) + " edges.");
+
+  // A chunk may end in the middle of an edge, so the tokens are read as one
+  // sequence: token k is endpoint k % 2 of edge k / 2.
+  auto for_each_edge = [&](auto body) {
+    bool second = false;
+    int u = 0;
+    for (auto &chunk : tokens)
+      for (int x : chunk) {
+        if (second)
+          body(u, x);
+        else
+          u = x;
+        second = !second;
+      }
+  };
+
+  // Build adjacency with one counting pass.
+  Graph graph(n);
+  for_each_edge([&](int u, int v) {
+    if (u == v)
+      throw std::runtime_error("Malformed input: loop at vertex " +
+                               std::to_string(u) + ".");
+    graph.off[u + 1]++;
+    graph.off[v + 1]++;
+  });
+  for (int v = 1; v <= n; v++)
+    graph.off[v + 1] += graph.off[v];
+
+  graph.adj.resize(2 * (size_t)m);
+  std::vector<int> pos(graph.off.begin(), graph.off.end() - 1);
+  for_each_edge([&](int u, int v) {
+    graph.adj[pos[u]++] = v;
+    graph.adj[pos[v]++] = u;
+  });
+  merge_parallel_edges(graph);
+
+  if (exceeds_euler_bound(n, graph.edges()))
+    throw std::invalid_argument("The graph is not planar.");
+  return graph;
+}
+
+GraphStreamReader::GraphStreamReader(int _fd)
+    : fd(_fd), buffer(1 << 20), pos(0), len(0), eof(false), broken(false) {}
+
+// Moves unread bytes to the front and reads more. Returns false if nothing
+// more could be read.
+bool GraphStreamReader::fill() {
+  if (eof)
+    return false;
+  std::copy(buffer.begin() + pos, buffer.begin() + len, buffer.begin());
+  len -= pos;
+  pos = 0;
+  if (len == buffer.size())
+    return false;
+
+  ssize_t r;
+  do
+    r = ::read(fd, buffer.data() + len, buffer.size() - len);
+  while (r < 0 && errno == EINTR);
+  if (r <= 0) {
+    eof = true;
+    return false;
+  }
+  len += r;
+  return true;
+}
+
+// Skips whitespace and finds the next token, which is then
+// buffer[pos..end). Returns false at the end of the stream.
+bool GraphStreamReader::next_span(size_t &end) {
+  while (true) {
+    while (pos < len && is_space(buffer[pos]))
+      pos++;
+    if (pos == len) {
+      if (!fill())
+        return false;
+      continue;
+    }
+
+    size_t q = pos;
+    while (q < len && !is_space(buffer[q]))
+      q++;
+    if (q == len && fill())
+      continue; // The token may go on in the next block.
+
+    // fill() may have moved the data even if it read nothing.
+    q = pos;
+    while (q < len && !is_space(buffer[q]))
+      q++;
+    end = q;
+    return true;
+  }
+}
+
+// Returns 1 if a token was read into x, 0 at the end of the stream and -1 if
+// the token is not a non-negative integer.
+int GraphStreamReader::next_token(int &x) {
+  size_t q;
+  if (!next_span(q))
+    return 0;
+
+  const char *begin = buffer.data() + pos;
+  const char *end = buffer.data() + q;
+  auto [p, ec] = std::from_chars(begin, end, x);
+  pos = q;
+  return (ec == std::errc() && p == end && x >= 0) ? 1 : -1;
+}
+
+bool GraphStreamReader::read_keyword(std::string_view word) {
+  size_t q;
+  if (broken || !next_span(q) ||
+      std::string_view(buffer.data() + pos, q - pos) != word)
+    return false;
+  pos = q;
+  return true;
+}
+
+bool GraphStreamReader::read(Graph &graph) {
+  if (broken)
+    return false;
+
+  auto fail = [&]() {
+    broken = true;
+    throw std::runtime_error("Malformed input: expected non-negative "
+                             "integers.");
+  };
+
+  int n, m;
+  int r = next_token(n);
+  if (r == 0)
+    return false;
+  if (r < 0 || next_token(m) <= 0)
+    fail();
+
+  bool in_range = true;
+  std::vector<std::pair<int, int>> edges;
+  // The header is not trusted with the allocation, edges grow as they come.
+  edges.reserve(std::min(m, 1 << 20));
+
+  for (int i = 0; i < m; i++) {
+    int u, v;
+    if (next_token(u) <= 0 || next_token(v) <= 0)
+      fail();
+    in_range &= (u >= 1 && u <= n && v >= 1 && v <= n && u != v);
+    if (in_range)
+      edges.emplace_back(u, v);
+  }
+
+  if (!in_range)
+    throw std::runtime_error("Malformed input: edge endpoint outside of "
+                             "[1, n] or loop.");
+
+  graph = build_graph(n, edges);
+  merge_parallel_edges(graph);
+  if (exceeds_euler_bound(n, graph.edges()))
+    throw std::invalid_argument("The graph is not planar.");
+  return true;
+}
+
+namespace {
+
+void put_u32(std::string &out, uint32_t x) {
+  for (int i = 0; i < 4; i++)
+    out.push_back((char)((x >> (8 * i)) & 0xff));
+}
+
+void put_varint(std::string &out, uint32_t x) {
+  while (x >= 0x80) {
+    out.push_back((char)(x | 0x80));
+    x >>= 7;
+  }
+  out.push_back((char)x);
+}
+
+inline uint32_t zigzag(int32_t x) {
+  return ((uint32_t)x << 1) ^ (uint32_t)(x >> 31);
+}
+
+} // namespace
+
+std::string encode_embedding(const std::vector<std::pair<int, int>> &coords,
+                             OutputFormat format) {
+  std::string out;
+  size_t n = coords.size();
+
+  if (format == OutputFormat::Text) {
+    // Longest line is two 10-digit numbers, a space and a newline.
+    out.resize(22 * n);
+    char *p = out.data();
+    for (auto &[x, y] : coords) {
+      p = std::to_chars(p, p + 11, x).ptr;
+      *p++ = ' ';
+      p = std::to_chars(p, p + 11, y).ptr;
+      *p++ = '\n';
+    }
+    out.resize(p - out.data());
+    return out;
+  }
+
+  out.reserve(12 + 8 * n);
+  out.append("ARAE");
+  out.push_back(1);
+  out.push_back(format == OutputFormat::Binary ? 0 : 1);
+  out.append(2, 0);
+  put_u32(out, n);
+
+  for (int c = 0; c < 2; c++) {
+    int prev = 0;
+    for (auto &xy : coords) {
+      int value = (c == 0) ? xy.first : xy.second;
+      if (format == OutputFormat::Binary)
+        put_u32(out, value);
+      else
+        put_varint(out, zigzag(value - prev));
+      prev = value;
+    }
+  }
+
+  return out;
+}
+
+void write_all(int fd, const std::string &buffer) {
+  const char *p = buffer.data();
+  size_t left = buffer.size();
+  while (left > 0) {
+    ssize_t written = write(fd, p, left);
+    if (written < 0) {
+      if (errno == EINTR)
+        continue;
+      throw std::runtime_error("Failed to write output.");
+    }
+    p += written;
+    left -= written;
+  }
+}
@@ -1,38 +1,160 @@
+#include "batch.hpp"
+#include "cache.hpp"
 #include "embedding.hpp"
-#include <fstream>
+#include "graph.hpp"
+#include "io.hpp"
+#include "profile.hpp"
+#include "reduction.hpp"
+#include "server.hpp"
+#include <cstdlib>
+#include <fcntl.h>
 #include <iostream>
-#include <list>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
 #include <vector>
 
-std::vector<std::list<int>> input(std::ifstream &input_file) {
-  int n, m;
-  input_file >> n >> m;
-  std::vector<std::list<int>> list(n + 1);
-  int u, v;
-  for (int i = 0; i < m; i++) {
-    input_file >> u >> v;
-    list[u].push_back(v);
-    list[v].push_back(u);
-  }
-
-  return list;
-}
+const char *USAGE =
+    "Usage: aracli [--output-format=text|binary|varint] [--profile]\n"
+    "              [--pack-components] [--threads=N]\n"
+    "              [--cache=directory [--cache-size=MB]] [input file path]\n"
+    "       aracli --test-only [--profile] [input file path]\n"
+    "       aracli --batch [input file path|-] [--unordered] [--threads=N]\n"
+    "              [--output-format=text|binary|varint]\n"
+    "       aracli --serve socket path [--threads=N]\n"
+    "              [--output-format=text|binary|varint]\n";
 
 int main(int argc, char *argv[]) {
-  if (argc < 2) {
-    std::cout << "Usage: aracli [input file path].\n";
+  OutputFormat format = OutputFormat::Text;
+  const char *input_path = nullptr;
+  bool batch = false;
+  bool serve = false;
+  bool profiled = false;
+  bool pack_components = false;
+  bool test_only = false;
+  bool threaded = false;
+  const char *cache_directory = nullptr;
+  long long cache_mb = 1024;
+  BatchOptions batch_options;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--output-format=text")
+      format = OutputFormat::Text;
+    else if (arg == "--output-format=binary")
+      format = OutputFormat::Binary;
+    else if (arg == "--output-format=varint")
+      format = OutputFormat::Varint;
+    else if (arg == "--batch")
+      batch = true;
+    else if (arg == "--pack-components")
+      pack_components = true;
+    else if (arg == "--test-only")
+      test_only = true;
+    else if (arg == "--profile")
+      profiled = true;
+    else if (arg == "--serve")
+      serve = true;
+    else if (arg == "--unordered")
+      batch_options.ordered = false;
+    else if (arg.rfind("--threads=", 0) == 0) {
+      batch_options.threads = std::atoi(arg.c_str() + 10);
+      threaded = true;
+    } else if (arg.rfind("--cache=", 0) == 0)
+      cache_directory = argv[i] + 8;
+    else if (arg.rfind("--cache-size=", 0) == 0)
+      cache_mb = std::atoll(arg.c_str() + 13);
+    else if ((arg == "-" || arg.rfind("--", 0) != 0) && !input_path)
+      input_path = argv[i];
+    else {
+      std::cout << USAGE;
+      return 1;
+    }
+  }
+
+  if (!input_path || (batch && serve) ||
+      ((profiled || pack_components || cache_directory) && (batch || serve)) ||
+      (pack_components && cache_directory) ||
+      (test_only && (batch || serve || pack_components || cache_directory ||
+                     threaded))) {
+    std::cout << USAGE;
     return 1;
   }
 
-  std::ifstream input_file;
-  input_file.open(argv[1]);
+  try {
+    if (serve) {
+      ServeOptions serve_options;
+      serve_options.threads = batch_options.threads;
+      serve_options.format = format;
+      run_server(input_path, serve_options);
+      return 0;
+    }
 
-  std::vector<std::list<int>> list = input(input_file);
+    if (batch) {
+      int fd = STDIN_FILENO;
+      if (std::string(input_path) != "-" &&
+          (fd = open(input_path, O_RDONLY)) == -1)
+        throw std::runtime_error("Failed to open input file.");
 
-  std::vector<std::pair<int, int>> embedding = planar_embedding(list);
+      batch_options.format = format;
+      run_batch(fd, STDOUT_FILENO, batch_options);
+      return 0;
+    }
 
-  embedding.erase(embedding.begin());
+#ifdef ARA_PROFILE
+    profile::Profile profile;
+    profile::Session session(profiled ? &profile : nullptr);
+#else
+    if (profiled)
+      throw std::runtime_error("aracli was built without ARA_PROFILE.");
+#endif
+    ARA_PROFILE_LAPS(laps);
 
-  for (auto &[x, y] : embedding)
-    std::cout << x << " " << y << "\n";
+    Graph graph;
+    bool planar = true;
+    try {
+      graph = read_graph(input_path);
+    } catch (const std::invalid_argument &) {
+      // More than 3n - 6 edges left after merging repeated ones, which
+      // answers the test on its own.
+      if (!test_only)
+        throw;
+      planar = false;
+    }
+    ARA_PROFILE_LAP(laps, "read_graph");
+    int threads = threaded ? batch_options.threads : 1;
+    if (test_only) {
+      if (planar) {
+        planar = test_planarity_reduced(graph);
+        ARA_PROFILE_RESET(laps); // test_planarity_reduced records its stages
+      }
+      write_all(STDOUT_FILENO, planar ? "planar\n" : "not planar\n");
+      ARA_PROFILE_LAP(laps, "write_output");
+    } else {
+      std::vector<std::pair<int, int>> embedding;
+      if (pack_components)
+        embedding =
+            planar_embedding_by_components(graph, batch_options.threads);
+      else if (cache_directory)
+        embedding = ResultCache(cache_directory, cache_mb << 20)
+                        .planar_embedding(graph, threads);
+      else
+        embedding = planar_embedding(graph, threads);
+      ARA_PROFILE_RESET(laps); // planar_embedding records its own stages
+
+      embedding.erase(embedding.begin());
+
+      write_all(STDOUT_FILENO, encode_embedding(embedding, format));
+      ARA_PROFILE_LAP(laps, "write_output");
+    }
+
+#ifdef ARA_PROFILE
+    if (profiled)
+      std::cerr << profile.to_json() << "\n";
+#endif
+    return planar ? 0 : 1;
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
 }
@@ -0,0 +1,62 @@
+#include "parallel.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Number of worker threads to use by default, i.e. number of hardware threads
+ * (at least 1).
+ */
+int default_threads() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/**
+ * Runs body(i) for every i in [0, count) on up to threads threads. Blocks
+ * until all calls finish. Rethrows the first exception thrown by body.
+ *
+ * @param count Number of tasks.
+ * @param threads Number of threads, 0 means default_threads().
+ * @param body Task to run.
+ */
+void parallel_for(int count, int threads,
+                  const std::function<void(int)> &body) {
+  if (threads <= 0)
+    threads = default_threads();
+  threads = std::min(threads, count);
+
+  if (threads <= 1) {
+    for (int i = 0; i < count; i++)
+      body(i);
+    return;
+  }
+
+  std::atomic<int> next(0);
+  std::exception_ptr error;
+  std::mutex error_mutex;
+
+  auto worker = [&]() {
+    for (int i = next++; i < count; i = next++) {
+      try {
+        body(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!error)
+          error = std::current_exception();
+      }
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for (int t = 1; t < threads; t++)
+    pool.emplace_back(worker);
+  worker();
+  for (auto &thread : pool)
+    thread.join();
+
+  if (error)
+    std::rethrow_exception(error);
+}
@@ -1,5 +1,12 @@
+#include "planar.hpp"
+#include "graph.hpp"
+#include "half_edge.hpp"
+#include "parallel.hpp"
+#include "profile.hpp"
 #include "utils.hpp"
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <vector>
 
 void update_low(int &low, int &low2, int x) {
@@ -16,20 +23,44 @@ void update_low(int &low, int &low2, int x) {
  * - low2[v] second best candidate for low[v] (low[v] = low2[v] iff there is
  *     only one candidate for low[v] - v itself)
  * - T set of edges in DFS orientation (tree + backwards edges)
+ * The search is iterative, so its depth is not limited by the call stack.
  */
-void dfs1(int v, int f, std::vector<bool> &visited, int &last_preorder,
-          std::vector<std::list<int>> &list, std::vector<int> &preorder,
+void dfs1(int root, std::vector<bool> &visited, int &last_preorder,
+          const Graph &graph, std::vector<int> &preorder,
           std::vector<int> &low, std::vector<int> &low2,
-          std::vector<std::pair<int, int>> &T) {
-  visited[v] = true;
-  preorder[v] = ++last_preorder;
-  low[v] = low2[v] = preorder[v];
-  for (auto u : list[v]) {
+          std::vector<std::pair<int, int>> &T,
+          std::vector<PlanarityWorkspace::Frame> &stack) {
+  stack.clear();
+  stack.reserve(graph.n + 1);
+
+  auto enter = [&](int v, int f) {
+    visited[v] = true;
+    preorder[v] = ++last_preorder;
+    low[v] = low2[v] = preorder[v];
+    stack.push_back({v, f, graph.off[v]});
+  };
+
+  enter(root, 0);
+  while (!stack.empty()) {
+    int v = stack.back().v;
+    int f = stack.back().f;
+    int i = stack.back().i;
+
+    if (i == graph.off[v + 1]) {
+      stack.pop_back();
+      if (!stack.empty()) {
+        int p = stack.back().v;
+        update_low(low[p], low2[p], low[v]);
+        update_low(low[p], low2[p], low2[v]);
+      }
+      continue;
+    }
+
+    stack.back().i++;
+    int u = graph.adj[i];
     if (!visited[u]) { // tree edge
       T.push_back({v, u});
-      dfs1(u, v, visited, last_preorder, list, preorder, low, low2, T);
-      update_low(low[v], low2[v], low[u]);
-      update_low(low[v], low2[v], low2[u]);
+      enter(u, v);
     } else if (u != f && preorder[v] > preorder[u]) { // back edge
       T.push_back({v, u});
       update_low(low[v], low2[v], preorder[u]);
@@ -41,18 +72,17 @@ void dfs1(int v, int f, std::vector<bool> &visited, int &last_preorder,
  */
 inline bool is_T(std::pair<int, int> e) { return e.first < e.second; }
 
-inline bool conflict(EdgeRange &I, EnumEdge &e, std::vector<int> &low_e) {
-  return !I.is_empty() && low_e[I.high.id] > low_e[e.id];
+inline bool conflict(const EdgeRange &I, int e, std::vector<int> &low_e) {
+  return !I.is_empty() && low_e[I.high] > low_e[e];
 }
 
-EdgeRange merge_edge_ranges(EdgeRange &A, EdgeRange B,
-                            std::vector<EnumEdge> &ref,
-                            std::vector<int> &side) {
+EdgeRange merge_edge_ranges(EdgeRange &A, EdgeRange B, std::vector<int> &ref,
+                            std::vector<int8_t> &side) {
   if (A.is_empty())
     return B;
   if (!B.is_empty()) {
-    ref[B.low.id] = A.high;
-    side[B.low.id] = 1;
+    ref[B.low] = A.high;
+    side[B.low] = 1;
   }
   if (B.is_empty())
     B.high = A.high;
@@ -61,11 +91,12 @@ EdgeRange merge_edge_ranges(EdgeRange &A, EdgeRange B,
 }
 
 /* Subprocedure of dfs2, returns false if graph is detected to not be planar. */
-bool merge(EnumEdge &e, EnumEdge &e_i, int bottom, std::vector<int> &low_e,
-           std::vector<EnumEdge> &low_edge, std::vector<EnumEdge> &ref,
-           std::vector<int> &side, std::vector<EdgeConstraint> &S) {
+bool merge(int e, int e_i, int bottom, int low_edge, std::vector<int> &low_e,
+           std::vector<int> &ref, std::vector<int8_t> &side,
+           std::vector<EdgeConstraint> &S) {
   EdgeConstraint P;
   while ((int)S.size() - 1 > bottom) {
+    ARA_PROFILE_ADD(MERGE_ITERATIONS, 1);
     EdgeConstraint q = S.back();
     S.pop_back();
     if (!q.L.is_empty() && !q.R.is_empty())
@@ -73,15 +104,16 @@ bool merge(EnumEdge &e, EnumEdge &e_i, int bottom, std::vector<int> &low_e,
     if (!q.L.is_empty())
       std::swap(q.L, q.R);
 
-    if (low_e[q.R.low.id] == low_e[e.id]) {
-      ref[q.R.low.id] = low_edge[e.id];
-      side[q.R.low.id] = 1;
+    if (low_e[q.R.low] == low_e[e]) {
+      ref[q.R.low] = low_edge;
+      side[q.R.low] = 1;
     } else
       P.R = merge_edge_ranges(q.R, P.R, ref, side);
   }
 
   while (!S.empty() && (conflict(S.back().L, e_i, low_e) ||
                         conflict(S.back().R, e_i, low_e))) {
+    ARA_PROFILE_ADD(MERGE_ITERATIONS, 1);
     EdgeConstraint q = S.back();
     S.pop_back();
 
@@ -100,46 +132,51 @@ bool merge(EnumEdge &e, EnumEdge &e_i, int bottom, std::vector<int> &low_e,
   return true;
 }
 
-int lowest(EdgeConstraint &P, std::vector<int> &low_e) {
+int lowest(const EdgeConstraint &P, std::vector<int> &low_e) {
   if (P.L.is_empty())
-    return low_e[P.R.low.id];
+    return low_e[P.R.low];
   if (P.R.is_empty())
-    return low_e[P.L.low.id];
-  return std::min(low_e[P.L.low.id], low_e[P.R.low.id]);
+    return low_e[P.L.low];
+  return std::min(low_e[P.L.low], low_e[P.R.low]);
 }
 
-void remove(int f, std::vector<int> &low_e, std::vector<EnumEdge> &ref,
-            std::vector<int> &side, std::vector<EdgeConstraint> &S) {
+void remove(int f, std::vector<int> &low_e, std::vector<int> &ref,
+            std::vector<int8_t> &side, std::vector<EdgeConstraint> &S) {
   EdgeConstraint P;
   while (!S.empty() && lowest(S.back(), low_e) == f) {
+    ARA_PROFILE_ADD(REMOVE_ITERATIONS, 1);
     P = S.back();
     S.pop_back();
 
-    if (P.L.low.a != -1)
-      side[P.L.low.id] = -1;
-    if (P.R.low.a != -1)
-      side[P.R.low.id] = 1;
+    if (P.L.low != NO_EDGE)
+      side[P.L.low] = -1;
+    if (P.R.low != NO_EDGE)
+      side[P.R.low] = 1;
   }
 
   if (!S.empty()) {
     P = S.back();
     S.pop_back();
     // Remove edges from P.L.
-    while (!P.L.is_empty() && low_e[P.L.high.id] == f)
-      P.L.high = ref[P.L.high.id];
-    if (P.L.high.is_empty() && !P.L.low.is_empty()) {
-      ref[P.L.low.id] = P.R.low;
-      side[P.L.low.id] = -1;
-      P.L.low = P.L.high = EnumEdge::empty();
+    while (P.L.high != NO_EDGE && low_e[P.L.high] == f) {
+      ARA_PROFILE_ADD(REMOVE_ITERATIONS, 1);
+      P.L.high = ref[P.L.high];
+    }
+    if (P.L.high == NO_EDGE && P.L.low != NO_EDGE) {
+      ref[P.L.low] = P.R.low;
+      side[P.L.low] = -1;
+      P.L.low = P.L.high = NO_EDGE;
     }
 
     // Remove edges from P.R.
-    while (!P.R.is_empty() && low_e[P.R.high.id] == f)
-      P.R.high = ref[P.R.high.id];
-    if (P.R.high.is_empty() && !P.R.low.is_empty()) {
-      ref[P.R.low.id] = P.L.low;
-      side[P.R.low.id] = -1;
-      P.R.low = P.R.high = EnumEdge::empty();
+    while (P.R.high != NO_EDGE && low_e[P.R.high] == f) {
+      ARA_PROFILE_ADD(REMOVE_ITERATIONS, 1);
+      P.R.high = ref[P.R.high];
+    }
+    if (P.R.high == NO_EDGE && P.R.low != NO_EDGE) {
+      ref[P.R.low] = P.L.low;
+      side[P.R.low] = -1;
+      P.R.low = P.R.high = NO_EDGE;
     }
 
     if (!P.is_empty())
@@ -147,273 +184,672 @@ void remove(int f, std::vector<int> &low_e, std::vector<EnumEdge> &ref,
   }
 }
 
-bool dfs2(int v, EnumEdge e,
-          std::vector<std::vector<std::pair<int, int>>> &elist,
-          std::vector<int> &low_e, std::vector<int> &bottom,
-          std::vector<EnumEdge> &low_edge, std::vector<EnumEdge> &ref,
-          std::vector<int> &side, std::vector<EdgeConstraint> &S) {
-  for (auto &[u, id] : elist[v]) {
-    EnumEdge e_i(v, u, id);
-    bottom[e_i.id] = S.size() - 1;
-    if (is_T({v, u})) {
-      if (!dfs2(u, e_i, elist, low_e, bottom, low_edge, ref, side, S))
-        return false;
-    } else {
-      low_edge[e_i.id] = e_i;
-      S.emplace_back(EnumEdge::empty(), EnumEdge::empty(), e_i, e_i);
+/* Iterative search, so its depth is not limited by the call stack. Edge ids
+ * are positions in elist, so the head of edge e is elist.adj[e]. Bottom and
+ * low_edge of an edge are needed only while the search is at its tail, so
+ * they live in the frames. Returns false if graph is detected to not be
+ * planar. */
+bool dfs2(int root, const Graph &elist, std::vector<int> &low_e,
+          std::vector<int> &ref, std::vector<int8_t> &side,
+          std::vector<EdgeConstraint> &S,
+          std::vector<PlanarityWorkspace::EdgeFrame> &stack) {
+  stack.clear();
+  stack.reserve(elist.n + 1);
+  stack.push_back(
+      {NO_EDGE, root, elist.off[root], NO_EDGE, -1, NO_EDGE, false});
+
+  auto head = [&](int e) { return (e == NO_EDGE) ? -1 : elist.adj[e]; };
+
+  while (!stack.empty()) {
+    PlanarityWorkspace::EdgeFrame &F = stack.back();
+    int e = F.e;
+    int v = F.v;
+    int i = F.i;
+
+    if (i < elist.off[v + 1]) {
+      int u = elist.adj[i];
+      int e_i = i;
+      if (!F.returned) {
+        F.bottom = S.size() - 1;
+        if (is_T({v, u})) {
+          F.returned = true;
+          stack.push_back(
+              {e_i, u, elist.off[u], NO_EDGE, -1, NO_EDGE, false});
+          continue;
+        }
+        F.low_edge_i = e_i;
+        S.emplace_back(NO_EDGE, NO_EDGE, e_i, e_i);
+        ARA_PROFILE_MAX(FMR_STACK_PEAK, S.size());
+      }
+      F.returned = false;
+      F.i++;
+
+      if (low_e[e_i] < v) {
+        if (i == elist.off[v]) // e_i is the first edge from v
+          F.low_edge = F.low_edge_i;
+        else if (!merge(e, e_i, F.bottom, F.low_edge, low_e, ref, side, S))
+          return false;
+      }
+      continue;
     }
 
-    if (low_e[e_i.id] < v) {
-      if (u == elist[v][0].first) // e_i is the first edge from v
-        low_edge[e.id] = low_edge[e_i.id];
-      else if (!merge(e, e_i, bottom[e_i.id], low_e, low_edge, ref, side, S))
-        return false;
-    }
-  }
+    int low_edge = F.low_edge;
+    stack.pop_back();
 
-  int f = e.a;
+    if (e != NO_EDGE) {
+      stack.back().low_edge_i = low_edge;
 
-  if (f != 0) {
-    // Remove all edges going to f from S.
-    remove(f, low_e, ref, side, S);
+      // Remove all edges going to f = the parent of v from S.
+      int f = stack.back().v;
+      remove(f, low_e, ref, side, S);
 
-    // Set ref[e = {w, v}] to be the edge f = {x, high[e]}. If it exists, it
-    // must be on top of S.
-    EnumEdge g;
+      // Set ref[e = {w, v}] to be the edge f = {x, high[e]}. If it exists, it
+      // must be on top of S.
+      int g = NO_EDGE;
 
-    if (!S.empty()) {
-      EdgeConstraint P = S.back();
-      g = (P.L.high.b > P.R.high.b) ? P.L.high : P.R.high;
+      if (!S.empty()) {
+        EdgeConstraint P = S.back();
+        g = (head(P.L.high) > head(P.R.high)) ? P.L.high : P.R.high;
+      }
+      ref[e] = g;
     }
-    ref[e.id] = g;
   }
 
   return true;
 }
 
-int eval_sign(int e_id, std::vector<int> &sign, std::vector<EnumEdge> &ref,
-              std::vector<int> &side) {
-  if (sign[e_id] == 0 && ref[e_id].is_empty())
-    sign[e_id] = side[e_id];
-  else if (sign[e_id] == 0)
-    sign[e_id] = side[e_id] * eval_sign(ref[e_id].id, sign, ref, side);
+/* Evaluates sign of the edge by following its ref chain up to the first edge
+ * of known sign, then stores sign of every edge on the chain. */
+int eval_sign(int e_id, std::vector<int8_t> &sign, std::vector<int> &ref,
+              std::vector<int8_t> &side) {
+  // sign[e] = side[e] * sign[ref[e]], so the sign of e_id is the product of
+  // sides along the chain and the sign at its end.
+  int x = e_id;
+  int product = 1;
+  while (sign[x] == 0 && ref[x] != NO_EDGE) {
+    product *= side[x];
+    x = ref[x];
+  }
+  if (sign[x] == 0)
+    sign[x] = side[x];
+  product *= sign[x];
+
+  for (int y = e_id; y != x; y = ref[y]) {
+    sign[y] = product;
+    product *= side[y];
+  }
   return sign[e_id];
 }
 
-void dfs3(int v, int f, std::vector<bool> &visited,
-          std::vector<std::list<std::pair<int, int>>> &adj,
-          std::vector<int> &sign,
-          std::vector<std::list<std::pair<int, int>>::iterator> &left,
-          std::vector<std::list<std::pair<int, int>>::iterator> &right) {
-  visited[v] = true;
-  auto it = adj[v].begin();
-  while (it != adj[v].end()) {
-    std::pair<int, int> e = *it;
-    int w = e.first;
-    int id = e.second;
+/* Builds rotation system from signs of edges. Iterative, so its depth is not
+ * limited by the call stack. */
+void dfs3(int root, std::vector<bool> &visited, HalfEdgeGraph &adj,
+          std::vector<int8_t> &sign, std::vector<int> &left,
+          std::vector<int> &right,
+          std::vector<PlanarityWorkspace::Frame> &stack) {
+  using Frame = PlanarityWorkspace::Frame;
+  stack.clear();
+  stack.reserve(adj.n + 1);
+
+  // Next half-edge in rotation of F.v, read from its first one, -1 after the
+  // last one.
+  auto advance = [&](Frame &F) {
+    F.i = (adj.next[F.i] == adj.first[F.v]) ? -1 : adj.next[F.i];
+  };
+
+  visited[root] = true;
+  stack.push_back({root, 0, adj.first[root]});
+  while (!stack.empty()) {
+    Frame &F = stack.back();
+    int v = F.v;
+
+    if (F.i == -1) {
+      stack.pop_back();
+      if (!stack.empty())
+        advance(stack.back());
+      continue;
+    }
+
+    int h = F.i;
+    int w = adj.head[h];
 
     if (!visited[w]) { // tree edge
-      adj[w].push_front({v, -1});
-      left[v] = right[v] = it;
-      dfs3(w, v, visited, adj, sign, left, right);
-    } else if (w != f && v > w) { // back edge
-      if (sign[id] == 1) {        // right edge
-        right[w] = adj[w].insert(right[w], {v, -1});
+      adj.push_front(h ^ 1);
+      left[v] = right[v] = h;
+      visited[w] = true;
+      stack.push_back({w, v, adj.first[w]});
+      continue;
+    } else if (w != F.f && v > w) { // back edge
+      if (sign[h / 2] == 1) {       // right edge
+        adj.insert_before(right[w], h ^ 1);
+        right[w] = h ^ 1;
       } else { // left edge
-        adj[w].insert(std::next(left[w]), {v, -1});
+        adj.insert_after(left[w], h ^ 1);
       }
     }
 
-    std::advance(it, 1);
+    advance(F);
   }
 }
 
-/** Checks whether graph is planar and returns its combinatoric
- * embedding if it is. Uses Fraysseix-Mendez-Rosenstiehl algorithm. Assumes the
- * graph is connected and has no multiedges or loops.
- *
- * @complexity O(|V|)
- * @param list Adjacency list of the graph
- * @return Adjacency list sorted according to combinatoric embedding if the
- * graph is planar, empty list otherwise.
- */
-std::vector<std::list<int>> is_planar(std::vector<std::list<int>> list) {
-  int n = list.size() - 1;
-
-  if (n == 1)
-    return {{}, {}};
-  else if (n == 2)
-    return {{}, {2}, {1}};
-
-  int m = 0;
-  for (int v = 1; v <= n; v++)
-    m += list[v].size();
-  m /= 2;
-
-  // Following Euler's formula, |E| <= 3 * |V| - 6 for all planar graphs with
-  // |V| >= 3.
-  if (m > 3 * n - 6)
-    return {};
+/* Frees the buffers of vectors. */
+template <typename... Vectors> void free_all(Vectors &...vectors) {
+  (std::vector<typename Vectors::value_type>().swap(vectors), ...);
+}
 
-  std::vector<int> preorder(n + 1, 0);
-  std::vector<int> low(n + 1, 0);
-  std::vector<int> low2(n + 1, 0);
+/* Orients the graph by dfs1 and runs dfs2 from every root, leaving in ws the
+ * preorder, the roots, the oriented graph elist in preorder labels with edges
+ * in order B, and ref and side of every edge. With release, buffers of a
+ * workspace used only once are freed as soon as they are dead. Returns false
+ * if graph is detected to not be planar. */
+bool orient(const Graph &graph, PlanarityWorkspace &ws, bool release) {
+  int n = graph.n;
+  std::vector<int> &preorder = ws.preorder, &low = ws.low, &low2 = ws.low2;
+  preorder.assign(n + 1, 0);
+  low.assign(n + 1, 0);
+  low2.assign(n + 1, 0);
 
   int last_preorder = 0;
-  std::vector<bool> visited(n + 1, false);
-  std::vector<std::pair<int, int>> T;
-
-  dfs1(1, 0, visited, last_preorder, list, preorder, low, low2, T);
+  ws.visited.assign(n + 1, false);
+  std::vector<std::pair<int, int>> &T = ws.arcs;
+  T.clear();
 
-  // Remove edges not appearing in DFS orientation. (in other words, orient the
-  // graph according to dfs orientation).
+  // Roots of DFS trees, one per connected component, in preorder labels.
+  ws.roots.clear();
   for (int v = 1; v <= n; v++)
-    list[v].clear();
-  for (auto e : T)
-    list[e.first].push_back(e.second);
-
-  // Renumerate adjacency list according to preorder.
-  renumerate(list, preorder);
-
-  // Calculate order B on edges.
-  std::vector<std::vector<std::pair<int, int>>> B(2 * n + 3);
-  for (int v = 1; v <= n; v++) {
-    for (auto u : list[v]) {
-      if (is_T({v, u}))
-        B[(low2[u] >= v) ? 2 * low[u] : 2 * low[u] + 1].push_back({v, u});
-      else
-        B[2 * u].push_back({v, u});
+    if (!ws.visited[v]) {
+      ws.roots.push_back(last_preorder + 1);
+      dfs1(v, ws.visited, last_preorder, graph, preorder, low, low2, T,
+           ws.frames);
     }
-  }
-
-  // Sort adjacency list according to calculated order B and enhance edges with
-  // id.
-  std::vector<std::vector<std::pair<int, int>>> elist(n + 1);
-  int e_id = 0;
-  for (int c = 1; c <= 2 * n + 1; c++)
-    for (auto edge : B[c])
-      elist[edge.first].emplace_back(std::make_pair(edge.second, e_id++));
+  if (release)
+    free_all(ws.frames);
+
+  // Remove edges not appearing in DFS orientation (in other words, orient the
+  // graph according to dfs orientation), in preorder labels.
+  Graph &list = ws.list;
+  list.n = n;
+  list.off.assign(n + 2, 0);
+  for (auto [v, u] : T)
+    list.off[preorder[v] + 1]++;
+  for (int v = 1; v <= n; v++)
+    list.off[v + 1] += list.off[v];
+  list.adj.resize(T.size());
+  std::vector<int> &pos = ws.pos;
+  pos.assign(list.off.begin(), list.off.end() - 1);
+  for (auto [v, u] : T)
+    list.adj[pos[preorder[v]]++] = preorder[u];
 
   // Renumerate low function indices according to preorder.
-  std::vector<int> _low(n + 1);
-  std::vector<int> _low2(n + 1);
-  for (int v = 1; v <= n; v++) {
-    _low[preorder[v]] = low[v];
-    _low2[preorder[v]] = low2[v];
+  for (std::vector<int> *f : {&low, &low2}) {
+    ws.relabel.resize(n + 1);
+    for (int v = 1; v <= n; v++)
+      ws.relabel[preorder[v]] = (*f)[v];
+    std::swap(*f, ws.relabel);
   }
-  low = _low;
-  low2 = _low2;
 
-  // Calculate low function for edges.
-  std::vector<int> low_e(e_id);
+  // Calculate order B on edges: bucket of every edge, then edges grouped by
+  // bucket with a counting sort. B takes the place of T.
+  auto bucket = [&](int v, int u) {
+    if (is_T({v, u}))
+      return (low2[u] >= v) ? 2 * low[u] : 2 * low[u] + 1;
+    return 2 * u;
+  };
+  std::vector<int> &B_off = ws.bucket_off;
+  B_off.assign(2 * n + 4, 0);
   for (int v = 1; v <= n; v++)
-    for (auto &[u, id] : elist[v])
-      low_e[id] = is_T({v, u}) ? low[u] : u;
-
-  std::vector<int> bottom(e_id), side(e_id);
-  std::vector<EnumEdge> ref(e_id), low_edge(e_id);
-  std::vector<EdgeConstraint> S;
+    for (auto u : list.neighbours(v))
+      B_off[bucket(v, u) + 1]++;
+  for (int c = 1; c <= 2 * n + 2; c++)
+    B_off[c + 1] += B_off[c];
+  std::vector<std::pair<int, int>> &B = ws.arcs;
+  for (int v = 1; v <= n; v++)
+    for (auto u : list.neighbours(v))
+      B[B_off[bucket(v, u)]++] = {v, u};
+  if (release)
+    free_all(B_off, low2, ws.relabel);
+
+  // Sort adjacency list according to calculated order B. The id of an edge
+  // is its position in elist, which takes the buffers of list, replaced by B.
+  Graph &elist = ws.elist;
+  elist.n = n;
+  std::swap(elist.off, list.off);
+  std::swap(elist.adj, list.adj);
+  pos.assign(elist.off.begin(), elist.off.end() - 1);
+  for (auto [v, u] : B)
+    elist.adj[pos[v]++] = u;
+  int e_id = elist.adj.size();
+  if (release)
+    free_all(B, pos);
 
-  // All edges are in R by default.
+  // Calculate low function for edges.
+  std::vector<int> &low_e = ws.low_e;
+  low_e.resize(e_id);
   for (int v = 1; v <= n; v++)
-    for (auto &[u, id] : elist[v]) {
-      side[id] = 1;
-      ref[id] = EnumEdge(-1, -1, -1);
+    for (int i = elist.off[v]; i < elist.off[v + 1]; i++) {
+      int u = elist.adj[i];
+      low_e[i] = is_T({v, u}) ? low[u] : u;
     }
+  if (release)
+    free_all(low);
 
-  if (!dfs2(1, EnumEdge(0, 1, -2), elist, low_e, bottom, low_edge, ref, side,
-            S))
-    return {};
+  // All edges are in R by default.
+  ws.side.assign(e_id, 1);
+  ws.ref.assign(e_id, NO_EDGE);
+  std::vector<EdgeConstraint> &S = ws.constraints;
+
+  // Constraints left by a component never conflict with edges of later ones,
+  // but they are dropped anyway to keep S small.
+  for (int root : ws.roots) {
+    S.clear();
+    if (!dfs2(root, elist, low_e, ws.ref, ws.side, S, ws.edge_frames))
+      return false;
+  }
+  if (release)
+    free_all(ws.low_e, ws.edge_frames);
 
-  // Evaluate sign of each edge based on calculation in dfs2.
-  std::vector<int> sign(e_id, 0);
-  for (int v = 1; v <= n; v++)
-    for (auto &[u, id] : elist[v])
-      sign[id] = eval_sign(id, sign, ref, side);
+  return true;
+}
+
+/* is_planar, releasing buffers as orient does. */
+Graph find_embedding(const Graph &graph, PlanarityWorkspace &ws,
+                     bool release) {
+  int n = graph.n;
+
+  // Every rotation system of a graph with at most 2 vertices is planar.
+  if (n <= 2)
+    return graph;
 
-  // Find embedding for DFS-orientation edges.
-  std::vector<std::list<std::pair<int, int>>> adj(n + 1);
+  int m = graph.edges();
+  if (exceeds_euler_bound(n, m))
+    return Graph();
+
+  if (!orient(graph, ws, release))
+    return Graph();
+  const Graph &elist = ws.elist;
+  int e_id = elist.half_edges();
+
+  // Evaluate sign of each edge based on calculation in dfs2.
+  std::vector<int8_t> &sign = ws.sign;
+  sign.assign(e_id, 0);
+  for (int id = 0; id < e_id; id++)
+    sign[id] = eval_sign(id, sign, ws.ref, ws.side);
+  if (release)
+    free_all(ws.ref, ws.side);
+
+  // Find embedding for DFS-orientation edges. Edge id consists of half-edge
+  // 2 id out of its tail and half-edge 2 id + 1, linked at its head by dfs3.
+  HalfEdgeGraph &adj = ws.rotation;
+  adj.assign(n, e_id);
   for (int v = 1; v <= n; v++) {
-    for (auto &[u, id] : elist[v])
+    for (int id = elist.off[v]; id < elist.off[v + 1]; id++) {
+      adj.head[2 * id] = elist.adj[id];
+      adj.head[2 * id + 1] = v;
       if (sign[id] == -1) // left edges
-        adj[v].push_back({u, id});
+        adj.push_back(2 * id);
+    }
   }
   for (int v = 1; v <= n; v++) {
-    for (auto &[u, id] : elist[v])
+    for (int id = elist.off[v]; id < elist.off[v + 1]; id++)
       if (sign[id] == 1) // right edges
-        adj[v].push_front({u, id});
+        adj.push_front(2 * id);
   }
 
-  std::vector<std::list<std::pair<int, int>>::iterator> left(n + 1),
-      right(n + 1);
-  for (int v = 1; v <= n; v++)
-    visited[v] = false;
+  ws.left.resize(n + 1);
+  ws.right.resize(n + 1);
+  ws.visited.assign(n + 1, false);
 
-  dfs3(1, 0, visited, adj, sign, left, right);
+  for (int root : ws.roots)
+    dfs3(root, ws.visited, adj, sign, ws.left, ws.right, ws.frames);
 
-  // Generate return list from adj.
+  // Generate return graph from adj in the original vertex numbers.
+  std::vector<int> &preorder = ws.preorder;
+  Graph embedding(n);
+  for (int v = 1; v <= n; v++)
+    embedding.off[v + 1] = embedding.off[v] + adj.degree[preorder[v]];
+  std::vector<int> &preorder_inv = ws.relabel;
+  preorder_inv.resize(n + 1);
+  for (int v = 1; v <= n; v++)
+    preorder_inv[preorder[v]] = v;
+  embedding.adj.resize(2 * m);
+  int i = 0;
   for (int v = 1; v <= n; v++) {
-    list[v].clear();
-    for (auto &[u, id] : adj[v])
-      list[v].push_back(u);
+    int x = preorder[v];
+    if (adj.first[x] == -1)
+      continue;
+    int h = adj.first[x];
+    do {
+      embedding.adj[i++] = preorder_inv[adj.head[h]];
+      h = adj.next[h];
+    } while (h != adj.first[x]);
   }
 
-  return list;
+  return embedding;
 }
 
-/** Finds planar graphs faces. Assumes the graph has no loops or
- * multiedges.
+/** Checks whether graph is planar and returns its combinatoric
+ * embedding if it is. Uses Fraysseix-Mendez-Rosenstiehl algorithm. Every
+ * connected component is searched from its own root. Assumes the graph has no
+ * multiedges or loops.
  *
- *  @complexity O(|V|)
- *  @param list Enumerated adjacency list of graph (combinatorial embedding).
- *  @param CR Graph edges cross references.
- *  @return vector of graph faces.
+ * @complexity O(|V|)
+ * @param graph The graph.
+ * @return Graph with adjacency sorted according to combinatoric embedding if
+ * the graph is planar, empty graph otherwise.
  */
-std::vector<std::vector<std::pair<int, int>>>
-find_faces(std::vector<std::list<std::pair<int, int>>> &list,
-           std::vector<EdgeCrossRef> &CR) {
-  int n = list.size() - 1;
-  int m = CR.size() - 1;
-  std::vector<bool> visited(
-      2 * m, false); // tracking which directed edges have been used. Note
-                     // that directed edges have ids from [0..2m-1].
-
-  /** Get directed edge u->v id, where id param is the undirected edge id. */
-  auto dir_id = [&](int u, int v, int id) {
-    return (u < v) ? 2 * (id - 1) : 2 * (id - 1) + 1;
-  };
+Graph is_planar(const Graph &graph) {
+  PlanarityWorkspace workspace;
+  return find_embedding(graph, workspace, true);
+}
+
+/** Same as is_planar(graph), with buffers from workspace.
+ *
+ * @complexity O(|V|)
+ * @param graph The graph.
+ * @param workspace Buffers reused across calls.
+ * @return Graph with adjacency sorted according to combinatoric embedding if
+ * the graph is planar, empty graph otherwise.
+ */
+Graph is_planar(const Graph &graph, PlanarityWorkspace &workspace) {
+  return find_embedding(graph, workspace, false);
+}
 
-  std::vector<std::vector<std::pair<int, int>>> faces;
+/* test_planarity, releasing buffers as orient does. */
+bool test(const Graph &graph, PlanarityWorkspace &ws, bool release) {
+  int n = graph.n;
+  if (n <= 2)
+    return true;
+  if (exceeds_euler_bound(n, graph.edges()))
+    return false;
 
-  for (int u = 1; u <= n; u++) {
-    for (auto &[v, id] : list[u]) {
-      if (!visited[dir_id(u, v, id)]) {
-        faces.push_back({{u, id}});
-        visited[dir_id(u, v, id)] = true;
-        int x = u;
-        int y = v;
-        int e_id = id;
-        while (true) {
-          auto it = CR[e_id].getCrossRef(x);
+  return orient(graph, ws, release);
+}
+
+/** Checks whether graph is planar, without finding its embedding. Stops
+ * after dfs2 of the Fraysseix-Mendez-Rosenstiehl algorithm: signs of edges,
+ * the rotation system and the output graph are never built, which takes
+ * about half the time and memory of is_planar. Assumes the graph has no
+ * multiedges or loops.
+ *
+ * @complexity O(|V|)
+ * @param graph The graph.
+ * @return Whether the graph is planar.
+ */
+bool test_planarity(const Graph &graph) {
+  PlanarityWorkspace workspace;
+  return test(graph, workspace, true);
+}
+
+/** Same as test_planarity(graph), with buffers from workspace.
+ *
+ * @complexity O(|V|)
+ * @param graph The graph.
+ * @param workspace Buffers reused across calls.
+ * @return Whether the graph is planar.
+ */
+bool test_planarity(const Graph &graph, PlanarityWorkspace &workspace) {
+  return test(graph, workspace, false);
+}
 
-          it = (it == list[y].begin()) ? std::prev(list[y].end())
-                                       : std::prev(it);
+/** Checks whether graph is planar and returns its combinatoric embedding if
+ * it is, testing biconnected components (blocks) separately. A graph is
+ * planar iff all its blocks are. Blocks are first checked against Euler's
+ * bound, then embedded by is_planar on up to threads threads. Rotation of an
+ * articulation point is the concatenation of its rotations in its blocks,
+ * which places every block in a face of the others. Assumes the graph has no
+ * multiedges or loops.
+ *
+ * @complexity O(|V| + |E|)
+ * @param graph The graph.
+ * @param threads Number of threads, 0 means default_threads().
+ * @return Graph with adjacency sorted according to combinatoric embedding if
+ * the graph is planar, empty graph otherwise.
+ */
+Graph is_planar_by_blocks(const Graph &graph, int threads) {
+  int n = graph.n;
+  if (n <= 2)
+    return graph;
+  int m = graph.edges();
+  if (exceeds_euler_bound(n, m))
+    return Graph();
+
+  GraphConnectivity GC(enumerate_adjacency_list(graph));
+  const Graph &g = GC.graph;
+  int k = GC.getBlockCount();
+
+  // Endpoints of every edge and edges of every block, grouped by counting
+  // sort on block ids.
+  std::vector<std::pair<int, int>> endpoints(m + 1);
+  for (int v = 1; v <= n; v++)
+    for (int i = g.off[v]; i < g.off[v + 1]; i++)
+      if (v < g.adj[i])
+        endpoints[g.eid[i]] = {v, g.adj[i]};
+  std::vector<int> block_off(k + 2, 0), block_edges(m);
+  for (int e = 1; e <= m; e++)
+    block_off[GC.bcid[e] + 1]++;
+  for (int b = 1; b <= k; b++)
+    block_off[b + 1] += block_off[b];
+  std::vector<int> pos(block_off.begin(), block_off.end() - 1);
+  for (int e = 1; e <= m; e++)
+    block_edges[pos[GC.bcid[e]]++] = e;
+
+  // Vertices of every block, renumbered from 1 within the block, and its
+  // edges in these numbers.
+  std::vector<std::vector<int>> vertices(k + 1);
+  std::vector<std::vector<std::pair<int, int>>> edges(k + 1);
+  std::vector<int> local(n + 1, 0);
+  for (int b = 1; b <= k; b++) {
+    auto id = [&](int v) {
+      if (local[v] == 0) {
+        vertices[b].push_back(v);
+        local[v] = vertices[b].size();
+      }
+      return local[v];
+    };
+    for (int i = block_off[b]; i < block_off[b + 1]; i++) {
+      auto [u, v] = endpoints[block_edges[i]];
+      edges[b].push_back({id(u), id(v)});
+    }
+    for (int v : vertices[b])
+      local[v] = 0;
 
-          auto [z, next_e_id] = *it;
+    if (exceeds_euler_bound(vertices[b].size(), edges[b].size()))
+      return Graph();
+  }
 
-          if (visited[dir_id(y, z, next_e_id)])
-            break;
+  // Largest blocks first, so that no thread is left with a big one at the
+  // end. Bridges need no test.
+  std::vector<int> order;
+  for (int b = 1; b <= k; b++)
+    if (vertices[b].size() >= 3)
+      order.push_back(b);
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+    return edges[a].size() > edges[b].size();
+  });
+
+  std::vector<Graph> embedding(k + 1);
+  std::atomic<bool> planar(true);
+  parallel_for(order.size(), threads, [&](int i) {
+    int b = order[i];
+    if (!planar)
+      return;
+    embedding[b] = is_planar(build_graph(vertices[b].size(), edges[b]));
+    if (embedding[b].empty())
+      planar = false;
+  });
+  if (!planar)
+    return Graph();
+
+  // Concatenate rotations of every vertex in its blocks.
+  Graph result(n);
+  result.off = g.off;
+  result.adj.resize(g.half_edges());
+  pos.assign(result.off.begin(), result.off.end() - 1);
+  for (int b = 1; b <= k; b++) {
+    const std::vector<int> &V = vertices[b];
+    if (V.size() == 2) {
+      result.adj[pos[V[0]]++] = V[1];
+      result.adj[pos[V[1]]++] = V[0];
+      continue;
+    }
+    for (size_t x = 1; x <= V.size(); x++)
+      for (int y : embedding[b].neighbours(x))
+        result.adj[pos[V[x - 1]]++] = V[y - 1];
+  }
 
-          visited[dir_id(y, z, next_e_id)] = true;
-          faces.back().push_back({y, next_e_id});
+  return result;
+}
 
-          x = y;
-          y = z;
-          e_id = next_e_id;
+/**
+ * Finds faces of a combinatorial embedding, up to threads at a time. A face
+ * is traced from its smallest half-edge, and faces are ordered by it, so the
+ * result does not depend on threads. Assumes the graph has no loops or
+ * multiedges.
+ *
+ * Every thread scans its own range of half-edges and traces a face from
+ * each one not claimed yet, claiming half-edges with compare-and-swap until
+ * it runs into a claimed one. That one is where another trace of the face
+ * started, so the traces of a face link up into a cycle.
+ *
+ * @complexity O(|V|)
+ * @param graph Combinatorial embedding.
+ * @param threads Number of threads, 0 means default_threads().
+ * @return Faces of the graph.
+ */
+Faces find_faces(const HalfEdgeGraph &graph, int threads) {
+  int half_edges = graph.head.size();
+  int blocks = std::max(1, std::min(threads > 0 ? threads : default_threads(),
+                                    half_edges / 4096));
+  auto begin = [&](int b) { return (int)((long long)half_edges * b / blocks); };
+
+  // Trace of a block: half-edges trail[first..last) of the block along
+  // face_next, up to stop, where the next trace of the face starts (its own
+  // start if the trace went around). trail[at] is its smallest half-edge.
+  struct Trace {
+    int stop, first, last, at;
+  };
+  std::vector<std::vector<Trace>> traces(blocks);
+  std::vector<std::vector<int>> trails(blocks);
+  // Trace claiming every half-edge, as begin(b) + its index in traces[b],
+  // plus one. 0 if not claimed yet.
+  std::vector<std::atomic<int>> owner(half_edges);
+
+  parallel_for(blocks, threads, [&](int b) {
+    std::vector<int> &trail = trails[b];
+    trail.reserve(begin(b + 1) - begin(b));
+    for (int h = begin(b); h < begin(b + 1); h++) {
+      int label = begin(b) + traces[b].size() + 1;
+      int unclaimed = 0;
+      if (owner[h].load(std::memory_order_relaxed) != 0 ||
+          !owner[h].compare_exchange_strong(unclaimed, label,
+                                            std::memory_order_relaxed))
+        continue;
+      Trace trace = {h, (int)trail.size(), 0, (int)trail.size()};
+      trail.push_back(h);
+      for (int g = graph.face_next(h); g != h; g = graph.face_next(g)) {
+        unclaimed = 0;
+        if (!owner[g].compare_exchange_strong(unclaimed, label,
+                                              std::memory_order_relaxed)) {
+          trace.stop = g;
+          break;
         }
+        if (g < trail[trace.at])
+          trace.at = trail.size();
+        trail.push_back(g);
       }
+      trace.last = trail.size();
+      traces[b].push_back(trace);
     }
+  });
+
+  // A single block traces every face around from its smallest half-edge, in
+  // their order.
+  Faces faces;
+  if (blocks == 1) {
+    faces.off.reserve(traces[0].size() + 1);
+    for (auto &trace : traces[0])
+      faces.off.push_back(trace.first);
+    faces.off.push_back(half_edges);
+    faces.half_edges = std::move(trails[0]);
+    return faces;
   }
 
+  // Traces of all blocks, in one array from first[b] for block b.
+  std::vector<Trace> all;
+  std::vector<int> starts(blocks + 1), first(blocks);
+  for (int b = 0; b < blocks; b++) {
+    starts[b] = begin(b);
+    first[b] = all.size();
+    all.insert(all.end(), traces[b].begin(), traces[b].end());
+    std::vector<Trace>().swap(traces[b]);
+  }
+  starts[blocks] = half_edges;
+  int count = all.size();
+
+  // Index in all of the trace claiming h, and block of trace i.
+  auto claimer = [&](int h) {
+    int label = owner[h].load(std::memory_order_relaxed) - 1;
+    int b = std::upper_bound(starts.begin(), starts.end(), label) -
+            starts.begin() - 1;
+    return first[b] + label - starts[b];
+  };
+  auto trail = [&](int i) {
+    int b = std::upper_bound(first.begin(), first.end(), i) - first.begin() - 1;
+    return trails[b].data();
+  };
+  std::vector<int> next(count);
+  for (int i = 0; i < count; i++)
+    next[i] = claimer(all[i].stop);
+
+  // Every face as the trace holding its smallest half-edge and its size.
+  // Owner of that half-edge becomes -1 - the face, so that faces are listed
+  // in its order by one scan.
+  std::vector<int> min_trace, size;
+  std::vector<bool> linked(count, false);
+  for (int i = 0; i < count; i++) {
+    if (linked[i])
+      continue;
+    int best = i, min = trail(i)[all[i].at], total = 0, j = i;
+    do {
+      linked[j] = true;
+      total += all[j].last - all[j].first;
+      if (trail(j)[all[j].at] < min) {
+        best = j;
+        min = trail(j)[all[j].at];
+      }
+      j = next[j];
+    } while (j != i);
+    owner[min].store(-1 - (int)min_trace.size(), std::memory_order_relaxed);
+    min_trace.push_back(best);
+    size.push_back(total);
+  }
+
+  std::vector<int> order;
+  order.reserve(min_trace.size());
+  for (int h = 0; h < half_edges; h++) {
+    int label = owner[h].load(std::memory_order_relaxed);
+    if (label < 0)
+      order.push_back(-1 - label);
+  }
+  faces.off.resize(order.size() + 1, 0);
+  for (size_t f = 0; f < order.size(); f++)
+    faces.off[f + 1] = faces.off[f] + size[order[f]];
+  faces.half_edges.resize(half_edges);
+
+  // Copies the face from its smallest half-edge: the rest of its trace, the
+  // traces after it and the beginning of its trace.
+  int face_blocks = std::min<int>(blocks, order.size());
+  parallel_for(face_blocks, threads, [&](int b) {
+    for (int f = (long long)order.size() * b / face_blocks;
+         f < (long long)order.size() * (b + 1) / face_blocks; f++) {
+      int i = min_trace[order[f]];
+      int *out = faces.half_edges.data() + faces.off[f];
+      out = std::copy(trail(i) + all[i].at, trail(i) + all[i].last, out);
+      for (int j = next[i]; j != i; j = next[j])
+        out = std::copy(trail(j) + all[j].first, trail(j) + all[j].last, out);
+      std::copy(trail(i) + all[i].first, trail(i) + all[i].at, out);
+    }
+  });
+
   return faces;
 }
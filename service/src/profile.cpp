@@ -0,0 +1,58 @@
+#include "profile.hpp"
+#include <cstdio>
+#include <string>
+
+namespace profile {
+
+std::string Profile::to_json() const {
+  static const char *counter_names[COUNTER_COUNT] = {
+      "fmr_stack_peak",        "merge_iterations",  "remove_iterations",
+      "make_2connected_edges", "triangulate_edges", "kernel_vertices",
+  };
+
+  char number[32];
+  double total_ms = 0;
+  std::string json = "{\"stages\":[";
+  for (size_t i = 0; i < stages.size(); i++) {
+    std::snprintf(number, sizeof(number), "%.3f", stages[i].ms);
+    total_ms += stages[i].ms;
+    json += (i ? ",{\"name\":\"" : "{\"name\":\"") +
+            std::string(stages[i].name) + "\",\"ms\":" + number +
+            ",\"allocations\":" + std::to_string(stages[i].allocations) +
+            ",\"bytes\":" + std::to_string(stages[i].bytes) + "}";
+  }
+  std::snprintf(number, sizeof(number), "%.3f", total_ms);
+  json += std::string("],\"total_ms\":") + number + ",\"counters\":{";
+  for (int c = 0; c < COUNTER_COUNT; c++)
+    json += (c ? ",\"" : "\"") + std::string(counter_names[c]) +
+            "\":" + std::to_string(counters[c]);
+  json += "},\"face_sizes\":{";
+  bool first = true;
+  for (size_t k = 0; k < face_sizes.size(); k++) {
+    if (face_sizes[k] == 0)
+      continue;
+    json += (first ? "\"" : ",\"") + std::to_string(k) +
+            "\":" + std::to_string(face_sizes[k]);
+    first = false;
+  }
+  return json + "}}";
+}
+
+#ifdef ARA_PROFILE
+
+thread_local Profile *current = nullptr;
+
+static thread_local long long allocations = 0;
+static thread_local long long allocated_bytes = 0;
+
+long long thread_allocations() { return allocations; }
+long long thread_allocated_bytes() { return allocated_bytes; }
+
+void count_allocation(size_t size) {
+  allocations++;
+  allocated_bytes += size;
+}
+
+#endif
+
+} // namespace profile
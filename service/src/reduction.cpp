@@ -0,0 +1,305 @@
+#include "reduction.hpp"
+#include "graph.hpp"
+#include "planar.hpp"
+#include "profile.hpp"
+#include <algorithm>
+#include <vector>
+
+/**
+ * Builds the kernel of a graph. Assumes the graph has no multiedges or loops.
+ *
+ * @complexity O(|V| + |E|)
+ * @param graph The graph.
+ * @return Kernel of the graph.
+ */
+Kernel reduce_graph(const Graph &graph) {
+  int n = graph.n;
+
+  // Peel vertices of degree at most 1, the rest is the core. degree becomes
+  // the degree in the core.
+  std::vector<int> degree(n + 1);
+  std::vector<bool> peeled(n + 1, false);
+  std::vector<int> stack;
+  for (int v = 1; v <= n; v++) {
+    degree[v] = graph.degree(v);
+    if (degree[v] <= 1)
+      stack.push_back(v);
+  }
+  while (!stack.empty()) {
+    int v = stack.back();
+    stack.pop_back();
+    peeled[v] = true;
+    for (auto u : graph.neighbours(v))
+      if (!peeled[u] && --degree[u] == 1)
+        stack.push_back(u);
+  }
+
+  // Ends of chains, kernel vertices unless a chain keeps some of its own.
+  auto branch = [&](int v) { return !peeled[v] && degree[v] >= 3; };
+
+  // Chains, each walked once from one of its ends u: the other end w and the
+  // vertices in between, from u.
+  std::vector<int> chain_u, chain_w, chain_off(1, 0), inner;
+  std::vector<bool> walked(n + 1, false);
+  for (int u = 1; u <= n; u++) {
+    if (!branch(u))
+      continue;
+    for (auto x : graph.neighbours(u)) {
+      if (peeled[x] || branch(x) || walked[x])
+        continue;
+      int prev = u, v = x;
+      while (!branch(v)) {
+        walked[v] = true;
+        inner.push_back(v);
+        for (auto y : graph.neighbours(v))
+          if (!peeled[y] && y != prev) {
+            prev = v;
+            v = y;
+            break;
+          }
+      }
+      chain_u.push_back(u);
+      chain_w.push_back(v);
+      chain_off.push_back(inner.size());
+    }
+  }
+  int chains = chain_u.size();
+
+  // Number of vertices every chain keeps: two for a loop, one for a second
+  // edge between its ends. Chains are grouped by their smaller end a, and
+  // mark[b] == a iff there already is an edge {a, b}.
+  std::vector<int> keep(chains, 0);
+  std::vector<int> by_off(n + 2, 0), by(chains);
+  for (int i = 0; i < chains; i++)
+    by_off[std::min(chain_u[i], chain_w[i]) + 1]++;
+  for (int v = 1; v <= n; v++)
+    by_off[v + 1] += by_off[v];
+  std::vector<int> pos(by_off.begin(), by_off.end() - 1);
+  for (int i = 0; i < chains; i++)
+    by[pos[std::min(chain_u[i], chain_w[i])]++] = i;
+
+  std::vector<int> mark(n + 1, 0);
+  for (int a = 1; a <= n; a++) {
+    if (!branch(a))
+      continue;
+    for (auto b : graph.neighbours(a))
+      if (branch(b))
+        mark[b] = a;
+    for (int j = by_off[a]; j < by_off[a + 1]; j++) {
+      int i = by[j];
+      int b = std::max(chain_u[i], chain_w[i]);
+      if (b == a)
+        keep[i] = 2;
+      else if (mark[b] == a)
+        keep[i] = 1;
+      else
+        mark[b] = a;
+    }
+  }
+
+  // Kernel vertices: ends of chains, then vertices kept by chains.
+  Kernel kernel;
+  std::vector<int> local(n + 1, 0);
+  kernel.vertex.push_back(0);
+  auto add = [&](int v) {
+    local[v] = kernel.vertex.size();
+    kernel.vertex.push_back(v);
+  };
+  for (int v = 1; v <= n; v++)
+    if (branch(v))
+      add(v);
+  for (int i = 0; i < chains; i++) {
+    if (keep[i] >= 1)
+      add(inner[chain_off[i]]);
+    if (keep[i] == 2)
+      add(inner[chain_off[i + 1] - 1]);
+  }
+
+  // Kernel edges {v, w} with the neighbours of their ends towards each other.
+  struct Edge {
+    int v, w, via_v, via_w;
+  };
+  std::vector<Edge> edges;
+  for (int v = 1; v <= n; v++)
+    if (branch(v))
+      for (auto w : graph.neighbours(v))
+        if (v < w && branch(w))
+          edges.push_back({local[v], local[w], w, v});
+  for (int i = 0; i < chains; i++) {
+    // Chain as a path p = 0..k + 1 from u to w, kept at positions in kept.
+    int k = chain_off[i + 1] - chain_off[i];
+    auto at = [&](int p) {
+      if (p == 0)
+        return chain_u[i];
+      return (p == k + 1) ? chain_w[i] : inner[chain_off[i] + p - 1];
+    };
+    int kept[4] = {0}, count = 1;
+    if (keep[i] >= 1)
+      kept[count++] = 1;
+    if (keep[i] == 2)
+      kept[count++] = k;
+    kept[count++] = k + 1;
+    for (int j = 0; j + 1 < count; j++) {
+      int p = kept[j], q = kept[j + 1];
+      edges.push_back({local[at(p)], local[at(q)], at(p + 1), at(q - 1)});
+    }
+  }
+
+  int k = kernel.vertex.size() - 1;
+  Graph &g = kernel.graph;
+  g = Graph(k);
+  for (auto &e : edges) {
+    g.off[e.v + 1]++;
+    g.off[e.w + 1]++;
+  }
+  for (int v = 1; v <= k; v++)
+    g.off[v + 1] += g.off[v];
+  g.adj.resize(2 * edges.size());
+  kernel.via.resize(2 * edges.size());
+  pos.assign(g.off.begin(), g.off.end() - 1);
+  for (auto &e : edges) {
+    kernel.via[pos[e.v]] = e.via_v;
+    g.adj[pos[e.v]++] = e.w;
+    kernel.via[pos[e.w]] = e.via_w;
+    g.adj[pos[e.w]++] = e.v;
+  }
+
+  return kernel;
+}
+
+/**
+ * Combinatorial embedding of a graph from one of its kernel. Kernel vertices
+ * keep the rotation of the kernel, followed by their removed neighbours,
+ * other vertices keep their adjacency: a removed tree or a chain fits any
+ * corner.
+ *
+ * @complexity O(|V| + |E|)
+ * @param graph The graph.
+ * @param kernel Kernel of the graph.
+ * @param embedding Graph of the kernel with adjacency sorted according to its
+ * combinatorial embedding.
+ * @return Graph with adjacency sorted according to combinatorial embedding.
+ */
+Graph expand_embedding(const Graph &graph, const Kernel &kernel,
+                       const Graph &embedding) {
+  const Graph &g = kernel.graph;
+  Graph result = graph;
+  result.eid.clear();
+
+  // toward[w] is the neighbour of vertex[v] towards w, for neighbours w of
+  // kernel vertex v, and seen[x] == v for these neighbours x.
+  std::vector<int> toward(g.n + 1, 0), seen(graph.n + 1, 0);
+  for (int v = 1; v <= g.n; v++) {
+    for (int i = g.off[v]; i < g.off[v + 1]; i++) {
+      toward[g.adj[i]] = kernel.via[i];
+      seen[kernel.via[i]] = v;
+    }
+
+    int x = kernel.vertex[v];
+    int pos = result.off[x];
+    for (auto w : embedding.neighbours(v))
+      result.adj[pos++] = toward[w];
+    for (auto y : graph.neighbours(x))
+      if (seen[y] != v)
+        result.adj[pos++] = y;
+  }
+
+  return result;
+}
+
+/* Whether testing the kernel instead of the graph pays off. Peeling starts
+ * from vertices of degree at most 2: with few of them the kernel is most of
+ * the graph. Graphs over Euler's bound are rejected by the test at once. */
+bool reducible(const Graph &graph) {
+  int n = graph.n;
+  int small = 0;
+  for (int v = 1; v <= n; v++)
+    small += graph.degree(v) <= 2;
+  return small > 0 && small >= n / 8 &&
+         !exceeds_euler_bound(n, graph.edges());
+}
+
+/**
+ * Checks whether graph is planar and returns its combinatoric embedding if
+ * it is, running the planarity test only on its kernel. Trees, pendant trees
+ * and long paths cost a linear scan instead. Graphs with less than |V| / 8
+ * vertices of degree at most 2 are tested whole. Repeated edges are merged
+ * first, the embedding is then one of the merged graph. Assumes the graph has
+ * no loops.
+ *
+ * @complexity O(|V| + |E|)
+ * @param graph The graph.
+ * @param threads Number of threads. 1 tests the kernel with is_planar,
+ * other values with is_planar_by_blocks.
+ * @param workspace Buffers of is_planar reused across calls, or nullptr.
+ * @return Graph with adjacency sorted according to combinatoric embedding if
+ * the graph is planar, empty graph otherwise.
+ */
+Graph is_planar_reduced(const Graph &graph, int threads,
+                        PlanarityWorkspace *workspace) {
+  // Chains and the kernel assume a simple graph.
+  if (has_parallel_edges(graph)) {
+    Graph simple = graph;
+    merge_parallel_edges(simple);
+    return is_planar_reduced(simple, threads, workspace);
+  }
+
+  auto test = [&](const Graph &g) {
+    if (threads != 1)
+      return is_planar_by_blocks(g, threads);
+    return workspace ? is_planar(g, *workspace) : is_planar(g);
+  };
+
+  ARA_PROFILE_LAPS(laps);
+  if (!reducible(graph)) {
+    Graph embedding = test(graph);
+    ARA_PROFILE_LAP(laps, "is_planar");
+    return embedding;
+  }
+
+  Kernel kernel = reduce_graph(graph);
+  ARA_PROFILE_ADD(KERNEL_VERTICES, kernel.graph.n);
+  ARA_PROFILE_LAP(laps, "reduce_graph");
+
+  Graph embedding = test(kernel.graph);
+  ARA_PROFILE_LAP(laps, "is_planar");
+  if (embedding.empty())
+    return embedding;
+
+  embedding = expand_embedding(graph, kernel, embedding);
+  ARA_PROFILE_LAP(laps, "expand_embedding");
+
+  return embedding;
+}
+
+/**
+ * Checks whether graph is planar, running test_planarity only on its kernel,
+ * like is_planar_reduced. No embedding is built. Repeated edges are merged
+ * first. Assumes the graph has no loops.
+ *
+ * @complexity O(|V| + |E|)
+ * @param graph The graph.
+ * @return Whether the graph is planar.
+ */
+bool test_planarity_reduced(const Graph &graph) {
+  if (has_parallel_edges(graph)) {
+    Graph simple = graph;
+    merge_parallel_edges(simple);
+    return test_planarity_reduced(simple);
+  }
+
+  ARA_PROFILE_LAPS(laps);
+  if (!reducible(graph)) {
+    bool planar = test_planarity(graph);
+    ARA_PROFILE_LAP(laps, "test_planarity");
+    return planar;
+  }
+
+  Graph kernel = reduce_graph(graph).graph;
+  ARA_PROFILE_ADD(KERNEL_VERTICES, kernel.n);
+  ARA_PROFILE_LAP(laps, "reduce_graph");
+
+  bool planar = test_planarity(kernel);
+  ARA_PROFILE_LAP(laps, "test_planarity");
+  return planar;
+}
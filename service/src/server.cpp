@@ -0,0 +1,319 @@
+#include "server.hpp"
+#include "batch.hpp"
+#include "graph.hpp"
+#include "io.hpp"
+#include "parallel.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+volatile std::sig_atomic_t stop_requested = 0;
+
+void request_stop(int) { stop_requested = 1; }
+
+/**
+ * Keeps the latencies of the last requests in a ring.
+ */
+class LatencyWindow {
+  std::mutex m;
+  std::vector<uint32_t> ring; // microseconds
+  size_t next = 0;
+  bool full = false;
+
+public:
+  explicit LatencyWindow(size_t size) : ring(std::max<size_t>(size, 1)) {}
+
+  void add(std::chrono::steady_clock::duration latency) {
+    auto us =
+        std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+    std::lock_guard<std::mutex> lock(m);
+    ring[next] = (uint32_t)std::min<long long>(us, UINT32_MAX);
+    if (++next == ring.size()) {
+      next = 0;
+      full = true;
+    }
+  }
+
+  /**
+   * Computes percentiles of the kept latencies.
+   *
+   * @complexity O(w log w), where w is the size of the window
+   * @param ps Percentiles, from [0, 100].
+   * @return Latency in microseconds for every percentile, 0 if none is kept.
+   */
+  std::vector<uint32_t> percentiles(const std::vector<double> &ps) {
+    std::vector<uint32_t> sorted;
+    {
+      std::lock_guard<std::mutex> lock(m);
+      sorted.assign(ring.begin(), full ? ring.end() : ring.begin() + next);
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    std::vector<uint32_t> result;
+    for (double p : ps) {
+      if (sorted.empty()) {
+        result.push_back(0);
+        continue;
+      }
+      size_t k = (size_t)(p / 100 * (sorted.size() - 1) + 0.5);
+      result.push_back(sorted[std::min(k, sorted.size() - 1)]);
+    }
+    return result;
+  }
+};
+
+class Server {
+  ServeOptions options;
+  size_t max_in_flight;
+  ThreadPool pool;
+  LatencyWindow latency;
+
+  std::atomic<long long> requests{0};
+  std::atomic<long long> errors{0};
+  std::atomic<long long> connections{0};
+  std::atomic<long long> in_flight{0};
+
+  std::string stats_json();
+
+public:
+  explicit Server(const ServeOptions &_options)
+      : options(_options), pool(_options.threads),
+        latency(_options.latency_window) {
+    max_in_flight =
+        options.max_in_flight > 0 ? options.max_in_flight : 64 * pool.size();
+  }
+
+  void serve_connection(int fd);
+};
+
+std::string Server::stats_json() {
+  std::vector<double> ps = {50, 90, 99, 99.9, 100};
+  std::vector<uint32_t> values = latency.percentiles(ps);
+  return "{\"requests\":" + std::to_string(requests) +
+         ",\"errors\":" + std::to_string(errors) +
+         ",\"connections\":" + std::to_string(connections) +
+         ",\"in_flight\":" + std::to_string(in_flight) +
+         ",\"queue_depth\":" + std::to_string(pool.queue_depth()) +
+         ",\"threads\":" + std::to_string(pool.size()) +
+         ",\"latency_us\":{\"p50\":" + std::to_string(values[0]) +
+         ",\"p90\":" + std::to_string(values[1]) +
+         ",\"p99\":" + std::to_string(values[2]) +
+         ",\"p999\":" + std::to_string(values[3]) +
+         ",\"max\":" + std::to_string(values[4]) + "}}";
+}
+
+// Answers requests read from fd until the client stops sending or a write
+// fails. Returns after all responses are written and the client has been sent
+// end of stream.
+void Server::serve_connection(int fd) {
+  connections++;
+  GraphStreamReader reader(fd);
+  RecordSink sink(fd, true, max_in_flight, true);
+  std::thread writer(&RecordSink::write_loop, &sink);
+
+  for (long long index = 0; sink.ok(); index++) {
+    sink.acquire();
+
+    if (reader.read_keyword("stats")) {
+      std::string json = stats_json();
+      sink.put(index, std::to_string(index) + " stats " +
+                          std::to_string(json.size()) + "\n" + json);
+      continue;
+    }
+
+    auto graph = std::make_shared<Graph>();
+    try {
+      if (!reader.read(*graph)) {
+        sink.put(index, ""); // release the slot
+        break;
+      }
+    } catch (const std::exception &e) {
+      requests++;
+      errors++;
+      sink.put(index, encode_error_record(index, e.what()));
+      if (!reader.ok())
+        break;
+      continue;
+    }
+
+    requests++;
+    in_flight++;
+    auto start = std::chrono::steady_clock::now();
+    pool.submit([this, &sink, graph, index, start]() {
+      std::string record;
+      if (!embed_record(index, *graph, options.format, record))
+        errors++;
+      latency.add(std::chrono::steady_clock::now() - start);
+      in_flight--;
+      sink.put(index, std::move(record));
+    });
+  }
+
+  sink.drain();
+  sink.close();
+  writer.join();
+  // The descriptor is closed when the thread is reaped.
+  shutdown(fd, SHUT_WR);
+  connections--;
+}
+
+/**
+ * Unix domain socket listening at a path, which is removed on destruction.
+ */
+class Listener {
+  std::string path;
+
+public:
+  int fd;
+
+  explicit Listener(const char *_path) : path(_path) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+      throw std::runtime_error("Socket path is too long.");
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    // Replace socket left by a server which did not exit cleanly, but not
+    // one which still accepts connections.
+    struct stat st;
+    if (lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+      int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+      if (probe == -1)
+        throw std::runtime_error("Failed to create socket.");
+      int result = connect(probe, (sockaddr *)&address, sizeof(address));
+      int error = errno;
+      close(probe);
+      if (result == 0)
+        throw std::runtime_error("Another server is already serving at the "
+                                 "socket path.");
+      if (error == ECONNREFUSED)
+        unlink(path.c_str());
+    }
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1)
+      throw std::runtime_error("Failed to create socket.");
+    if (bind(fd, (sockaddr *)&address, sizeof(address)) == -1) {
+      close(fd);
+      throw std::runtime_error("Failed to bind socket.");
+    }
+    if (listen(fd, SOMAXCONN) == -1) {
+      close(fd);
+      unlink(path.c_str());
+      throw std::runtime_error("Failed to listen on socket.");
+    }
+  }
+
+  ~Listener() {
+    close(fd);
+    unlink(path.c_str());
+  }
+
+  Listener(const Listener &) = delete;
+  Listener &operator=(const Listener &) = delete;
+};
+
+struct Connection {
+  int fd;
+  std::thread thread;
+  std::atomic<bool> done{false};
+};
+
+} // namespace
+
+void run_server(const char *socket_path, const ServeOptions &options) {
+  // Stop signals are blocked in every thread and only delivered to this one
+  // while it waits for connections.
+  sigset_t stop_signals, old_mask;
+  sigemptyset(&stop_signals);
+  sigaddset(&stop_signals, SIGINT);
+  sigaddset(&stop_signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &stop_signals, &old_mask);
+
+  struct sigaction action = {}, old_int, old_term, old_pipe;
+  action.sa_handler = request_stop;
+  sigaction(SIGINT, &action, &old_int);
+  sigaction(SIGTERM, &action, &old_term);
+  // A client which disconnects early must not kill the server.
+  action.sa_handler = SIG_IGN;
+  sigaction(SIGPIPE, &action, &old_pipe);
+  stop_requested = 0;
+
+  std::list<std::unique_ptr<Connection>> connections;
+  auto reap = [&](bool all) {
+    for (auto it = connections.begin(); it != connections.end();) {
+      if (!all && !(*it)->done) {
+        it++;
+        continue;
+      }
+      (*it)->thread.join();
+      close((*it)->fd);
+      it = connections.erase(it);
+    }
+  };
+
+  std::string error;
+  {
+    Server server(options);
+    try {
+      Listener listener(socket_path);
+
+      while (!stop_requested) {
+        pollfd p = {listener.fd, POLLIN, 0};
+        if (ppoll(&p, 1, nullptr, &old_mask) == -1) {
+          if (errno == EINTR)
+            continue;
+          throw std::runtime_error("Failed to wait for connections.");
+        }
+
+        int fd = accept4(listener.fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd == -1)
+          continue;
+
+        reap(false);
+        auto connection = std::make_unique<Connection>();
+        Connection *c = connection.get();
+        c->fd = fd;
+        c->thread = std::thread([&server, c]() {
+          server.serve_connection(c->fd);
+          c->done = true;
+        });
+        connections.push_back(std::move(connection));
+      }
+    } catch (const std::exception &e) {
+      error = e.what();
+    }
+
+    // Stop reading requests and let the accepted ones finish.
+    for (auto &c : connections)
+      shutdown(c->fd, SHUT_RD);
+    reap(true);
+  }
+
+  sigaction(SIGINT, &old_int, nullptr);
+  sigaction(SIGTERM, &old_term, nullptr);
+  sigaction(SIGPIPE, &old_pipe, nullptr);
+  pthread_sigmask(SIG_SETMASK, &old_mask, nullptr);
+
+  if (!error.empty())
+    throw std::runtime_error(error);
+}
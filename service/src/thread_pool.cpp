@@ -0,0 +1,99 @@
+#include "thread_pool.hpp"
+#include "parallel.hpp"
+
+// Pool the current thread works for and its index there.
+static thread_local const ThreadPool *current_pool = nullptr;
+static thread_local int current_worker = -1;
+
+ThreadPool::ThreadPool(int threads)
+    : next_queue(0), queued(0), unfinished(0), stop(false) {
+  if (threads <= 0)
+    threads = default_threads();
+  for (int i = 0; i < threads; i++)
+    queues.push_back(std::make_unique<Queue>());
+  for (int i = 0; i < threads; i++)
+    workers.emplace_back(&ThreadPool::run, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+  wait();
+  {
+    std::lock_guard<std::mutex> lock(m);
+    stop = true;
+  }
+  work_cv.notify_all();
+  for (auto &worker : workers)
+    worker.join();
+}
+
+size_t ThreadPool::queue_depth() {
+  std::lock_guard<std::mutex> lock(m);
+  return queued;
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+  int q = (current_pool == this) ? current_worker
+                                 : next_queue++ % queues.size();
+  {
+    std::lock_guard<std::mutex> lock(m);
+    queued++;
+    unfinished++;
+  }
+  {
+    std::lock_guard<std::mutex> lock(queues[q]->m);
+    queues[q]->tasks.push_back(std::move(task));
+  }
+  work_cv.notify_one();
+}
+
+void ThreadPool::wait() {
+  std::unique_lock<std::mutex> lock(m);
+  idle_cv.wait(lock, [&] { return unfinished == 0; });
+}
+
+bool ThreadPool::try_pop(int self, std::function<void()> &task) {
+  int k = queues.size();
+  for (int i = 0; i < k; i++) {
+    Queue &q = *queues[(self + i) % k];
+    std::lock_guard<std::mutex> lock(q.m);
+    if (q.tasks.empty())
+      continue;
+    if (i == 0) { // own deque, newest task
+      task = std::move(q.tasks.back());
+      q.tasks.pop_back();
+    } else { // steal oldest task
+      task = std::move(q.tasks.front());
+      q.tasks.pop_front();
+    }
+    return true;
+  }
+  return false;
+}
+
+void ThreadPool::run(int self) {
+  current_pool = this;
+  current_worker = self;
+
+  while (true) {
+    std::function<void()> task;
+    if (try_pop(self, task)) {
+      {
+        std::lock_guard<std::mutex> lock(m);
+        queued--;
+      }
+      task();
+      {
+        std::lock_guard<std::mutex> lock(m);
+        unfinished--;
+        if (unfinished == 0)
+          idle_cv.notify_all();
+      }
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(m);
+    work_cv.wait(lock, [&] { return stop || queued > 0; });
+    if (stop && queued == 0)
+      return;
+  }
+}
@@ -1,51 +1,48 @@
+#include "arena.hpp"
+#include "graph.hpp"
+#include "half_edge.hpp"
+#include "parallel.hpp"
 #include "planar.hpp"
+#include "profile.hpp"
 #include "utils.hpp"
 #include <algorithm>
-#include <list>
+#include <deque>
+#include <memory_resource>
 #include <queue>
+#include <span>
+#include <tuple>
 #include <vector>
 
 /**
  * Makes planar graph connected and calculates its new combinational embedding.
  * Since given combinational embedding, every face can be drawn as external,
- * this is a very simple procedure.
+ * this is a very simple procedure: the smallest vertices of consecutive
+ * components are joined with an edge.
  */
-void make_connected(std::vector<std::list<int>> &list) {
-  int n = list.size() - 1;
-  std::vector<bool> visited(n + 1, false);
-  std::vector<int> component_root;
-  std::queue<int> q;
-  for (int v = 1; v <= n; v++) {
-    if (!visited[v]) {
-      component_root.push_back(v);
-      q.push(v);
-      while (!q.empty()) {
-        int u = q.front();
-        q.pop();
-        for (auto w : list[u])
-          if (!visited[w]) {
-            visited[w] = true;
-            q.push(w);
-          }
-      }
+void make_connected(Graph &graph, int threads) {
+  std::vector<int> component;
+  int count = label_components(graph, component, threads);
+
+  // Component c starts at its smallest vertex, before those of c + 1.
+  std::vector<std::pair<int, int>> new_edges;
+  int root = 0;
+  for (int v = 1, c = 0; v <= graph.n && c < count; v++)
+    if (component[v] == c) {
+      if (c++ > 0)
+        new_edges.push_back({root, v});
+      root = v;
     }
-  }
 
-  for (int i = 0; i < (int)component_root.size() - 1; i++) {
-    int u = component_root[i];
-    int v = component_root[i + 1];
-    list[u].push_back(v);
-    list[v].push_back(u);
-  }
+  if (!new_edges.empty())
+    append_edges(graph, new_edges);
 }
 
 /**
  * Makes connected planar graph 2-connected. It does so by forming cycles
  * consisting of each articulation point's neighbors.
  */
-void make_2connected(std::vector<std::list<std::pair<int, int>>> &list,
-                     std::vector<EdgeCrossRef> &CR) {
-  GraphConnectivity GC(list);
+void make_2connected(HalfEdgeGraph &graph) {
+  GraphConnectivity GC(graph.to_graph(true));
   std::vector<int> bcid = GC.bcid;
   std::vector<int> art = GC.getArticulationPoints();
   std::reverse(art.begin(), art.end());
@@ -53,159 +50,247 @@ void make_2connected(std::vector<std::list<std::pair<int, int>>> &list,
   for (auto v : art) {
     int new_edges_bcid = (GC.p_edge_id[v] == -1) ? 0 : bcid[GC.p_edge_id[v]];
 
-    for (auto it = list[v].begin(); it != list[v].end(); ++it) {
-      auto it1 = std::next(it);
-      if (it1 == list[v].end()) {
-        if (list[v].size() > 2)
-          it1 = list[v].begin();
-        else
-          break;
-      }
-      auto [u1, e1] = *it;
-      auto [u2, e2] = *it1;
-
-      if (bcid[e1] != bcid[e2]) { // if e1 and e2 are not in the same
-                                  // biconnected comp, add edge u1-u2.
-        int new_edge_id = CR.size();
-        auto e1p_it = CR[e1].getCrossRef(v);
-        auto new_edge_it1 = list[u1].insert(e1p_it, {u2, new_edge_id});
-        auto e2p_it = CR[e2].getCrossRef(v);
-        auto new_edge_it2 =
-            list[u2].insert(std::next(e2p_it), {u1, new_edge_id});
-        CR.emplace_back(new_edge_it1, new_edge_it2);
+    int h1 = graph.first[v];
+    do {
+      int h2 = graph.next[h1];
+      if (h2 == graph.first[v] && graph.degree[v] <= 2)
+        break;
+      int u1 = graph.head[h1], u2 = graph.head[h2];
+
+      // If h1 and h2 are not in the same biconnected comp, add edge u1-u2.
+      // Edge ids of GC are shifted by one.
+      if (bcid[h1 / 2 + 1] != bcid[h2 / 2 + 1]) {
+        int e = graph.add_edge(u1, u2);
+        graph.insert_before(h1 ^ 1, 2 * e);
+        graph.insert_after(h2 ^ 1, 2 * e + 1);
         bcid.push_back(new_edges_bcid);
+        ARA_PROFILE_ADD(MAKE_2CONNECTED_EDGES, 1);
       }
-    }
+      h1 = h2;
+    } while (h1 != graph.first[v]);
   }
 }
 
-/** Triangulates given faces. Assumes graph is biconnected. */
-void triangulate_faces(std::vector<std::list<std::pair<int, int>>> &list,
-                       std::vector<EdgeCrossRef> &CR,
-                       std::vector<std::vector<std::pair<int, int>>> &faces) {
-  int n = list.size() - 1;
-  std::vector<bool> nx(n + 1, false);
-  for (auto &face : faces) {
-    int t = face.size();
-
-    // find vertex in face with minimum degree.
-    auto [x, _] = face[0];
-    int pos_x = 0;
-    for (int i = 1; i < t; i++) {
-      int v = face[i].first;
-      if (list[v].size() < list[x].size()) {
-        x = v;
-        pos_x = i;
-      }
+/* Picks the vertex x of face with the smallest degree, rotates the face to
+ * start from x and returns stop: the face is fanned from x up to face[stop],
+ * the first vertex already adjacent to x, and the rest from y =
+ * tail(face[stop - 1]), see add_chords. nx is all false and is left so. */
+int plan_face(const HalfEdgeGraph &graph, std::span<int> face,
+              std::vector<bool> &nx) {
+  int t = face.size();
+
+  // find vertex in face with minimum degree.
+  int x = graph.tail(face[0]);
+  int pos_x = 0;
+  for (int i = 1; i < t; i++) {
+    int v = graph.tail(face[i]);
+    if (graph.degree[v] < graph.degree[x]) {
+      x = v;
+      pos_x = i;
     }
+  }
 
-    // rotate face to make x the first element (for convenience).
-    std::rotate(face.begin(), face.begin() + pos_x, face.end());
+  // rotate face to make x the first element (for convenience).
+  std::rotate(face.begin(), face.begin() + pos_x, face.end());
 
-    // set neighbours of x.
-    for (auto &[v, _] : list[x])
-      nx[v] = true;
+  // Sets nx of neighbours of x to value.
+  auto mark = [&](bool value) {
+    int h = graph.first[x];
+    do {
+      nx[graph.head[h]] = value;
+      h = graph.next[h];
+    } while (h != graph.first[x]);
+  };
 
-    // triangulate as much as we can from x and let y be the last for which we
-    // succeeded.
-    auto [y, e1_id] = face[1];  // e1 = (y, z) at all times
-    int e2_id = face[0].second; // e2 = (x, y) at all times
+  mark(true);
+  int stop = 2;
+  while (stop <= t - 2 && !nx[graph.tail(face[stop])])
+    stop++;
+  mark(false);
+  return stop;
+}
 
-    int i = 2;
-    while (i <= t - 2) {
-      int z = face[i].first;
-      if (nx[z])
-        break;
+/* Calls hx = add(hx, hy) for the t - 3 chords of face planned by plan_face,
+ * in order, where the chord goes from tail(hx) to head[hy] = y->z and add
+ * returns the new half-edge out of tail(hx). */
+template <typename Add>
+void add_chords(std::span<const int> face, int stop, Add add) {
+  int t = face.size();
+
+  // triangulate as much as we can from x, hx = x->y and face[i - 1] = y->z.
+  int hx = face[0];
+  for (int i = 2; i < stop; i++)
+    hx = add(hx, face[i - 1]);
+
+  // if there is something left in the face, triangulate from y.
+  if (stop == t - 1)
+    return;
+  hx = face[stop - 1];
+  for (int i = stop + 1; i <= t - 1; i++)
+    hx = add(hx, face[i - 1]);
+}
 
-      // add edge e3 = (x, z)
-      int e3_id = CR.size();
-      auto e2_x_it = CR[e2_id].getCrossRef(y);
-      auto e3_x_it = list[x].insert(std::next(e2_x_it), {z, e3_id});
-      auto e1_z_it = CR[e1_id].getCrossRef(y);
-      auto e3_z_it = list[z].insert(e1_z_it, {x, e3_id});
-      CR.emplace_back(e3_x_it, e3_z_it);
-
-      e1_id = face[i].second;
-      e2_id = e3_id;
-      y = z;
-      i++;
+/**
+ * Triangulates given faces, up to threads at a time. Assumes graph is
+ * biconnected. Every face is fanned from its vertex of smallest degree, see
+ * plan_face, and the triangulation does not depend on threads.
+ *
+ * Faces are planned on the graph as given, by contiguous blocks, and their
+ * chords are linked at once: a face gets the edge ids following those of the
+ * faces before it and only splits its own corners, so the blocks write
+ * disjoint entries. Two faces may plan the same chord, across a separation
+ * pair. Every face with a chord of an earlier face is unlinked and planned
+ * again on the triangulated rest, one after another, into its own edge ids.
+ *
+ * @complexity O(|V|)
+ * @param graph The graph, with its combinatorial embedding.
+ * @param faces Faces of the graph, rotated in place.
+ * @param threads Number of threads, 0 means default_threads().
+ */
+void triangulate_faces(HalfEdgeGraph &graph, Faces &faces, int threads) {
+  int n = graph.n, m = graph.edges();
+  int count = faces.size();
+  int blocks = std::max(1, std::min(threads > 0 ? threads : default_threads(),
+                                    count / 1024));
+  auto begin = [&](int b) { return (long long)count * b / blocks; };
+
+  // First edge id of the chords of every face.
+  std::vector<int> base(count + 1, m);
+  for (int f = 0; f < count; f++)
+    base[f + 1] = base[f] + (int)faces[f].size() - 3;
+  int edges = base[count];
+  ARA_PROFILE_ADD(TRIANGULATE_EDGES, edges - m);
+
+  graph.head.resize(2 * edges);
+  graph.next.resize(2 * edges, -1);
+  graph.prev.resize(2 * edges, -1);
+  std::vector<int> stop(count, 2); // triangles have nothing to plan
+
+  parallel_for(blocks, threads, [&](int b) {
+    std::vector<bool> nx(n + 1, false);
+    for (int f = begin(b); f < begin(b + 1); f++)
+      if (faces[f].size() > 3)
+        stop[f] = plan_face(graph, faces[f], nx);
+  });
+
+  // Links chords as insert_after(hx, h) and insert_before(hy ^ 1, h + 1),
+  // leaving first and degree to be fixed once all are linked.
+  parallel_for(blocks, threads, [&](int b) {
+    for (int f = begin(b); f < begin(b + 1); f++) {
+      int e = base[f];
+      add_chords(faces[f], stop[f], [&](int hx, int hy) {
+        int h = 2 * e++, g = hy ^ 1;
+        graph.head[h] = graph.head[hy];
+        graph.head[h + 1] = graph.tail(hx);
+        graph.next[h] = graph.next[hx];
+        graph.prev[h] = hx;
+        graph.prev[graph.next[hx]] = h;
+        graph.next[hx] = h;
+        graph.next[h + 1] = g;
+        graph.prev[h + 1] = graph.prev[g];
+        graph.next[graph.prev[g]] = h + 1;
+        graph.prev[g] = h + 1;
+        return h;
+      });
+    }
+  });
+
+  // Chords grouped by their smaller end a, in order of ids, and mark[b] == a
+  // iff there already is a chord {a, b}. Only chords can repeat, as faces
+  // avoid edges of the graph as given. A half-edge h + 1 linked before first
+  // of its tail becomes first, as with insert_before.
+  std::vector<int> by_off(n + 2, 0), by(edges - m);
+  for (int e = m; e < edges; e++) {
+    int u = graph.head[2 * e], w = graph.head[2 * e + 1];
+    graph.degree[u]++;
+    graph.degree[w]++;
+    if (graph.next[2 * e + 1] == graph.first[u])
+      graph.first[u] = 2 * e + 1;
+    by_off[std::min(u, w) + 1]++;
+  }
+  for (int v = 1; v <= n; v++)
+    by_off[v + 1] += by_off[v];
+  std::vector<int> pos(by_off.begin(), by_off.end() - 1);
+  for (int e = m; e < edges; e++)
+    by[pos[std::min(graph.head[2 * e], graph.head[2 * e + 1])]++] = e;
+
+  std::vector<bool> deferred(count, false);
+  std::vector<int> mark(n + 1, 0);
+  for (int a = 1; a <= n; a++)
+    for (int j = by_off[a]; j < by_off[a + 1]; j++) {
+      int e = by[j];
+      int b = graph.head[2 * e] ^ graph.head[2 * e + 1] ^ a;
+      if (mark[b] == a)
+        deferred[std::upper_bound(base.begin(), base.end(), e) -
+                 base.begin() - 1] = true;
+      mark[b] = a;
     }
 
-    // unset neighbours of x.
-    for (auto &[v, _] : list[x])
-      nx[v] = false;
-
-    // if there is something left in the face, triangulate from y.
-    if (i == t - 1)
+  std::vector<bool> nx(n + 1, false);
+  for (int f = 0; f < count; f++) {
+    if (!deferred[f])
       continue;
-
-    x = y;
-    y = face[i].first;
-    e1_id = face[i].second;
-    e2_id = face[i - 1].second;
-    i++;
-
-    while (i <= t - 1) {
-      int z = face[i].first;
-
-      // add edge e3 = (x, z)
-      int e3_id = CR.size();
-      auto e2_x_it = CR[e2_id].getCrossRef(y);
-      auto e3_x_it = list[x].insert(std::next(e2_x_it), {z, e3_id});
-      auto e1_z_it = CR[e1_id].getCrossRef(y);
-      auto e3_z_it = list[z].insert(e1_z_it, {x, e3_id});
-      CR.emplace_back(e3_x_it, e3_z_it);
-
-      e1_id = face[i].second;
-      e2_id = e3_id;
-      y = z;
-      i++;
+    for (int h = 2 * base[f]; h < 2 * base[f + 1]; h++) {
+      int x = graph.tail(h);
+      if (graph.first[x] == h)
+        graph.first[x] = graph.next[h];
+      graph.next[graph.prev[h]] = graph.next[h];
+      graph.prev[graph.next[h]] = graph.prev[h];
+      graph.degree[x]--;
     }
   }
+  for (int f = 0; f < count; f++) {
+    if (!deferred[f])
+      continue;
+    stop[f] = plan_face(graph, faces[f], nx);
+    int e = base[f];
+    add_chords(faces[f], stop[f], [&](int hx, int hy) {
+      int h = 2 * e++;
+      graph.head[h] = graph.head[hy];
+      graph.head[h + 1] = graph.tail(hx);
+      graph.insert_after(hx, h);
+      graph.insert_before(hy ^ 1, h + 1);
+      return h;
+    });
+  }
 }
 
 /**
  * Returns combinational embedding of given planar graphs triangulation.
- * Does not assume the graph is connected. Assumes the provided adjacency list
+ * Does not assume the graph is connected. Assumes the provided graph
  * corresponds to a planar combinational embedding of the graph and that the
  * graph has at least 3 vertices and is loop-free and multiedge-free. The
  * algorithm first makes the graph connected, then 2-connected and at the end,
- * triangulates all faces.
+ * triangulates all faces, up to threads at a time. The triangulation does not
+ * depend on threads.
  *
  * @complexity O(|V|)
- * @param list Adjacency list of the graph (sorted according to combinational
+ * @param graph The graph (adjacency sorted according to combinational
  * embedding)
- * @return Adjacency list of graph triangulation
+ * @param threads Number of threads labelling components and triangulating
+ * faces, 0 means default_threads().
+ * @return Graph triangulation
  */
-std::vector<std::list<int>>
-get_triangulation(std::vector<std::list<int>> list) {
-  int n = list.size() - 1;
-  int m = 0;
-  for (auto &l : list)
-    m += l.size();
-  m /= 2;
+Graph get_triangulation(const Graph &graph, int threads) {
+  // Stacks of the augmentation live only until the triangulation is built.
+  arena::Scope scope(64ll * graph.n);
 
-  make_connected(list);
+  Graph connected = graph;
+  make_connected(connected, threads);
 
-  std::vector<std::list<std::pair<int, int>>> elist =
-      enumerate_adjacency_list(list);
+  // Augmentation splices new edges into rotations, so it works on half-edges,
+  // with room for all 3|V| - 6 edges of the triangulation.
+  HalfEdgeGraph embedding(connected);
+  embedding.reserve(3 * graph.n - 6);
 
-  std::vector<EdgeCrossRef> CR = getEdgeCrossReferences(elist);
+  make_2connected(embedding);
 
-  make_2connected(elist, CR);
+  Faces faces = find_faces(embedding, threads);
+  ARA_PROFILE_FACES(faces);
 
-  std::vector<std::vector<std::pair<int, int>>> faces = find_faces(elist, CR);
+  triangulate_faces(embedding, faces, threads);
 
-  triangulate_faces(elist, CR, faces);
-
-  // Build output.
-  for (int v = 1; v <= n; v++) {
-    list[v].clear();
-    for (auto &[u, id] : elist[v])
-      list[v].push_back(u);
-  }
-
-  return list;
+  return embedding.to_graph();
 }
 
 /**
@@ -213,27 +298,24 @@ get_triangulation(std::vector<std::list<int>> list) {
  * face f = {a, b, c}. c will be 0-root, a will be 2-root, b will be 1-root.
  *
  * @complexity O(|V|)
- * @param list Adjacency list of given graph. Assumes edges v-u in list[v] are
- * represented by pairs {u, id}, where id \in [1..m]
- * @return vector v such that v[edge_id] = {dir, color} and:
+ * @param graph Combinatorial embedding of the triangulation.
+ * @return vector v such that v[e] = {dir, color} for edge e and:
  *     - dir = -1 if the edge is directed towards vertex with smaller id, 1
  * otherwise,
  *     - color \in {0, 1, 2} represents the edge color.
  */
-std::vector<std::pair<int, int>>
-get_schnyder_wood(std::vector<std::list<std::pair<int, int>>> &list, int a,
-                  int b, int c) {
-  int n = list.size() - 1;
-  int m = 0;
-  for (auto &l : list)
-    m += l.size();
-  m /= 2;
-
-  std::vector<std::pair<int, int>> SW(m + 1, {-1, -1});
+std::vector<std::pair<int, int>> get_schnyder_wood(const HalfEdgeGraph &graph,
+                                                   int a, int b, int c) {
+  int n = graph.n;
+  int m = graph.edges();
+  const std::vector<int> &head = graph.head;
+  const std::vector<int> &next = graph.next;
+
+  std::vector<std::pair<int, int>> SW(m, {-1, -1});
   std::vector<bool> on_cycle(n + 1, false);
   std::vector<int> cycle_nodes(n + 1, 0);
   std::vector<bool> processed(n + 1, false);
-  std::queue<int> good_vertices;
+  std::queue<int, std::pmr::deque<int>> good_vertices(arena::resource());
 
   auto is_good = [&](int v) {
     bool is_interior = (v != a && v != b && v != c);
@@ -247,29 +329,26 @@ get_schnyder_wood(std::vector<std::list<std::pair<int, int>>> &list, int a,
 
   auto add_to_cycle = [&](int v) {
     on_cycle[v] = true;
-    for (auto &[u, id] : list[v]) {
-      cycle_nodes[u]++;
-      check(u);
-    }
+    int h = graph.first[v];
+    do {
+      cycle_nodes[head[h]]++;
+      check(head[h]);
+      h = next[h];
+    } while (h != graph.first[v]);
     check(v);
   };
 
-  for (auto &[u, e_id] : list[c]) {
+  int h = graph.first[c];
+  do {
+    int u = head[h];
     add_to_cycle(u);
     if (u != a && u != b)
-      SW[e_id] = {dir(u, c), 0};
-  }
+      SW[h / 2] = {dir(u, c), 0};
+    h = next[h];
+  } while (h != graph.first[c]);
 
   processed[c] = true;
 
-  /** Cyclic next in list. */
-  auto cnext = [](std::list<std::pair<int, int>> &l,
-                  typename std::list<std::pair<int, int>>::iterator &it) {
-    std::advance(it, 1);
-    if (it == l.end())
-      it = l.begin();
-  };
-
   // Main loop.
   while (!good_vertices.empty()) {
     int v = good_vertices.front();
@@ -279,49 +358,46 @@ get_schnyder_wood(std::vector<std::list<std::pair<int, int>>> &list, int a,
       continue;
 
     // Every good vertex has an already processed neighbour.
-    auto it = list[v].begin();
-    while (!processed[it->first])
-      ++it;
+    h = graph.first[v];
+    while (!processed[head[h]])
+      h = next[h];
 
     // Process cycle neighbour of v "to the right".
-    while (!on_cycle[it->first])
-      cnext(list[v], it);
+    while (!on_cycle[head[h]])
+      h = next[h];
 
-    cycle_nodes[it->first]--;
-    SW[it->second] = {dir(v, it->first), 1};
+    cycle_nodes[head[h]]--;
+    SW[h / 2] = {dir(v, head[h]), 1};
 
-    check(it->first);
+    check(head[h]);
 
-    cnext(list[v], it);
+    h = next[h];
 
     // Process all neighbours of v inside cycle.
-    while (!on_cycle[it->first]) {
-      cycle_nodes[it->first]--;
-      SW[it->second] = {dir(it->first, v), 0};
-      add_to_cycle(it->first);
+    while (!on_cycle[head[h]]) {
+      cycle_nodes[head[h]]--;
+      SW[h / 2] = {dir(head[h], v), 0};
+      add_to_cycle(head[h]);
 
-      cnext(list[v], it);
+      h = next[h];
     }
 
     // Process cycle neighbour of v "to the left".
-    cycle_nodes[it->first]--;
-    SW[it->second] = {dir(v, it->first), 2};
-    check(it->first);
+    cycle_nodes[head[h]]--;
+    SW[h / 2] = {dir(v, head[h]), 2};
+    check(head[h]);
 
     on_cycle[v] = false;
     processed[v] = true;
   }
 
   // The remaining edges are between a, b and c.
-  for (auto &[u, id] : list[a])
-    if (u == c)
-      SW[id] = {dir(a, c), 0};
-  for (auto &[u, id] : list[c])
-    if (u == b)
-      SW[id] = {dir(c, b), 1};
-  for (auto &[u, id] : list[b])
-    if (u == a)
-      SW[id] = {dir(b, a), 2};
+  for (auto [x, y, color] : {std::tuple{a, c, 0}, {c, b, 1}, {b, a, 2}}) {
+    h = graph.first[x];
+    while (head[h] != y)
+      h = next[h];
+    SW[h / 2] = {dir(x, y), color};
+  }
 
   return SW;
 }
@@ -1,4 +1,6 @@
+#include "arena.hpp"
 #include "utils.hpp"
+#include <algorithm>
 #include <vector>
 
 /**
@@ -19,135 +21,175 @@ std::vector<int> get_pi_inv(std::vector<int> &pi) {
  * Renumerate vertices of the graph according to function phi.
  *
  * @complexity O(|V| + |E|)
- * @param list Adjacency list of the graph G.
+ * @param graph The graph G.
  * @param phi Function [n] -> [n] according to which the enumeration should be
  * performed
  */
-void renumerate(std::vector<std::list<int>> &list, std::vector<int> &phi) {
-  int n = list.size() - 1;
-  std::vector<std::list<int>> _list(n + 1);
+void renumerate(Graph &graph, std::vector<int> &phi) {
+  int n = graph.n;
+  Graph _graph(n);
   for (int v = 1; v <= n; v++)
-    for (auto u : list[v])
-      _list[phi[v]].push_back(phi[u]);
-  list = _list;
+    _graph.off[phi[v] + 1] += graph.degree(v);
+  for (int v = 1; v <= n; v++)
+    _graph.off[v + 1] += _graph.off[v];
+
+  _graph.adj.resize(graph.adj.size());
+  for (int v = 1; v <= n; v++) {
+    int pos = _graph.off[phi[v]];
+    for (auto u : graph.neighbours(v))
+      _graph.adj[pos++] = phi[u];
+  }
+  graph = std::move(_graph);
 }
 
 /**
- * Enumerate edges with ids [1, m] from adjacency list maintaining vertices
- * order in each list.
+ * Enumerate edges with ids [1, m] maintaining vertices order in each
+ * adjacency.
  *
  * @complexity O(|V| + |E|)
- * @param list adjacency list to enumerate.
- * @return enumerated adjacency list.
+ * @param graph graph to enumerate.
+ * @return enumerated graph (eid filled).
  */
-std::vector<std::list<std::pair<int, int>>>
-enumerate_adjacency_list(const std::vector<std::list<int>> &list) {
-  int n = list.size() - 1;
-  std::vector<std::list<std::pair<int, int>>> elist(n + 1);
+Graph enumerate_adjacency_list(const Graph &graph) {
+  int n = graph.n;
+  Graph egraph = graph;
+  egraph.eid.assign(graph.adj.size(), 0);
+
+  // Ids of edges {v, u}, v < u, as seen from the side of u.
+  std::vector<int> in_off(n + 2, 0);
+  for (int v = 1; v <= n; v++)
+    for (auto u : graph.neighbours(v))
+      if (v < u)
+        in_off[u + 1]++;
+  for (int v = 1; v <= n; v++)
+    in_off[v + 1] += in_off[v];
+
+  std::vector<std::pair<int, int>> in(in_off[n + 1]);
   int m = 0;
   for (int v = 1; v <= n; v++) {
-    for (auto &u : list[v]) {
+    for (int i = graph.off[v]; i < graph.off[v + 1]; i++) {
+      int u = graph.adj[i];
       if (v < u) {
         m++;
-        elist[u].push_back({v, m});
-        elist[v].push_back({u, m});
+        egraph.eid[i] = m;
+        in[in_off[u]++] = {v, m};
       }
     }
   }
 
+  // After the pass above in_off[u] is the end of range of u.
   std::vector<int> my_ids(n + 1);
-  for (int v = 1; v <= n; v++) {
-    for (auto &[u, id] : elist[v])
-      my_ids[u] = id;
-    elist[v].clear();
-    for (auto &u : list[v])
-      elist[v].push_back({u, my_ids[u]});
+  for (int u = 1; u <= n; u++) {
+    for (int j = in_off[u - 1]; j < in_off[u]; j++)
+      my_ids[in[j].first] = in[j].second;
+    for (int i = graph.off[u]; i < graph.off[u + 1]; i++)
+      if (graph.adj[i] < u)
+        egraph.eid[i] = my_ids[graph.adj[i]];
   }
 
-  return elist;
+  return egraph;
 }
 
 /**
- * Build edge cross-references.
+ * Find twin of every half-edge, i.e. position of half-edge v->u for
+ * half-edge u->v.
  *
  * @complexity O(|V| + |E|)
- * @param elist enumerated adjacency list.
- * @param M max edge id. If equal to 0, assumed to be |E|.
- * @return vector of cross edge references.
+ * @param graph enumerated graph.
+ * @return vector twin such that twin[i] is the position of reverse of i.
  */
-std::vector<EdgeCrossRef>
-getEdgeCrossReferences(std::vector<std::list<std::pair<int, int>>> &elist,
-                       int M) {
-  int n = elist.size() - 1;
-
-  if (M == 0) {
-    for (auto &l : elist)
-      M += l.size();
-    M /= 2;
-  }
-
-  std::vector<EdgeCrossRef> CR(M + 1);
-  for (int v = 1; v <= n; v++) {
-    for (auto it = elist[v].begin(); it != elist[v].end(); ++it) {
-      int u = it->first;
-      int id = it->second;
-      if (v < u)
-        CR[id].it1 = it;
-      else
-        CR[id].it2 = it;
+std::vector<int> get_twins(const Graph &graph) {
+  int M = 0;
+  for (auto id : graph.eid)
+    M = std::max(M, id);
+
+  std::vector<int> first(M + 1, -1);
+  std::vector<int> twin(graph.adj.size());
+  for (int i = 0; i < graph.half_edges(); i++) {
+    int id = graph.eid[i];
+    if (first[id] == -1) {
+      first[id] = i;
+    } else {
+      twin[i] = first[id];
+      twin[first[id]] = i;
     }
   }
 
-  return CR;
+  return twin;
 }
 
-EnumEdge EnumEdge::empty() { return EnumEdge(-1, -1, -1); }
-
-void GraphConnectivity::dfs(int v, int parent_edge) {
-  visited[v] = true;
-  preorder[v] = low[v] = ++t;
-  p_edge_id[v] = parent_edge;
-
-  int cnt_children = 0;
-  for (auto &[u, id] : list[v]) {
-    if (!visited[u]) {
-      cnt_children++;
-      S.push(id);
-      dfs(u, id);
-      low[v] = std::min(low[v], low[u]);
-      if (low[u] >= preorder[v]) {
-        art[v] = true;
-        while (!S.empty()) {
-          int eid = S.top();
-          S.pop();
-          bcid[eid] = next_bcid;
-          if (eid == id)
-            break;
-        }
-        next_bcid++;
-      }
-    } else if (id != parent_edge) {
-      low[v] = std::min(low[v], preorder[u]);
-      if (preorder[u] < preorder[v])
+// Iterative, so its depth is not limited by the call stack.
+void GraphConnectivity::dfs(int root) {
+  struct Frame {
+    int v, parent_edge, i; // vertex, edge to its parent and current half-edge
+    int cnt_children;
+  };
+  std::vector<Frame> stack;
+  stack.reserve(n + 1);
+
+  auto enter = [&](int v, int parent_edge) {
+    visited[v] = true;
+    preorder[v] = low[v] = ++t;
+    p_edge_id[v] = parent_edge;
+    stack.push_back({v, parent_edge, graph.off[v], 0});
+  };
+
+  enter(root, -1);
+  while (!stack.empty()) {
+    Frame &F = stack.back();
+    int v = F.v;
+
+    if (F.i < graph.off[v + 1]) {
+      int u = graph.adj[F.i];
+      int id = graph.eid[F.i];
+      if (!visited[u]) {
+        F.cnt_children++;
         S.push(id);
+        enter(u, id);
+        continue;
+      } else if (id != F.parent_edge) {
+        low[v] = std::min(low[v], preorder[u]);
+        if (preorder[u] < preorder[v])
+          S.push(id);
+      }
+      F.i++;
+      continue;
     }
-  }
 
-  if (v == 1)
-    art[v] = (cnt_children >= 2);
-
-  if (parent_edge != -1 && low[v] == preorder[v])
-    bridge[parent_edge] = true;
+    int parent_edge = F.parent_edge;
+    if (v == root)
+      art[v] = (F.cnt_children >= 2);
+
+    if (parent_edge != -1 && low[v] == preorder[v])
+      bridge[parent_edge] = true;
+
+    stack.pop_back();
+    if (stack.empty())
+      break;
+
+    // Return to parent w, which has just finished the tree edge to v.
+    Frame &P = stack.back();
+    int w = P.v;
+    low[w] = std::min(low[w], low[v]);
+    if (low[v] >= preorder[w]) {
+      art[w] = true;
+      while (!S.empty()) {
+        int eid = S.top();
+        S.pop();
+        bcid[eid] = next_bcid;
+        if (eid == parent_edge)
+          break;
+      }
+      next_bcid++;
+    }
+    P.i++;
+  }
 }
 
-GraphConnectivity::GraphConnectivity(
-    std::vector<std::list<std::pair<int, int>>> _list)
-    : list(_list) {
-  n = list.size() - 1;
-  m = 0;
-  for (auto &l : list)
-    m += l.size();
-  m /= 2;
+GraphConnectivity::GraphConnectivity(Graph _graph)
+    : S(arena::resource()), graph(std::move(_graph)) {
+  n = graph.n;
+  m = graph.edges();
 
   bridge.assign(m + 1, false);
   art.assign(n + 1, false);
@@ -161,7 +203,9 @@ GraphConnectivity::GraphConnectivity(
   t = 0;
   next_bcid = 1;
 
-  dfs(1, -1);
+  for (int v = 1; v <= n; v++)
+    if (!visited[v])
+      dfs(v);
 }
 
 // Returns articulation points in increasing preorder.